@@ -23,8 +23,10 @@
 #include "distribution.h"
 #include "event.h"
 #include "scheduler.h"
+#include "rangen.h"
 
 #include <sstream>
+#include <cmath>
 
 using namespace std;
 
@@ -38,33 +40,36 @@ Ageable::Ageable(Creator *_creator)
     nextDeath = 0;*/
     binnum = creator->binnum;
     attr = 0;
+    attrcache = 0;
     attrfixed = 0;
     attrisfixed = 0;
+    attrisfixedperbin = 0;
+    attrfixedindex = 0;
     
-    attrfixed = new double*[creator->getCollector()->getNumberOfAttributes()];
-    for(int i = 0; i < creator->getCollector()->getNumberOfAttributes(); i++) 
-        attrfixed[i] = 0; 
-    
-    attrisfixed = 
-        creator->getCollector()->getAttributesIsFixedArray();
-    const bool * attrisfixedperbin = 
-        creator->getCollector()->getAttributesIsFixedPerBinArray();
-    attr = creator->getCollector()->getAttributesArray();
+    CreatorCollection *collection = creator->getCollector();
+    attrisfixed = collection->getAttributesIsFixedArray();
+    attrisfixedperbin = collection->getAttributesIsFixedPerBinArray();
+    attrfixedindex = collection->getAttributesFixedIndexArray();
+    attr = collection->getAttributesArray();
+    attrcache = collection->getAttributesCacheArray();
     
+    // one block for all fixed values, see getFixedAttribute()
+    attrfixedperbinpos = collection->getNumberOfFixedAttributes(false);
+    int size = attrfixedperbinpos + 
+        collection->getNumberOfFixedAttributes(true)*binnum;
+    if (size > 0) attrfixed = new Value[size];
     
-    for(int a = 0; a < creator->getCollector()->getNumberOfAttributes(); a++) {
-        attrfixed[a] = new double[binnum];
-        for (Bin b = 0; b < binnum; b++) {
-            if (attrisfixed[a]) {
-                if (!attrisfixedperbin[a] && b > 0) {
-                    attrfixed[a][b] = attrfixed[a][0];
-                } else {
-                    bin = b; 
-                    attrfixed[a][b] = attr[a]->dsample(this, global::abstime);
-                }
-            } else {
-                attrfixed[a][b] = 0.0;
+    for(int a = 0; a < collection->getNumberOfAttributes(); a++) {
+        if (!attrisfixed[a]) continue;
+        if (attrisfixedperbin[a]) {
+            for (Bin b = 0; b < binnum; b++) {
+                bin = b; 
+                getFixedAttribute(a, b) = 
+                    attr[a]->dsample(this, global::abstime);
             }
+        } else {
+            bin = 0;
+            getFixedAttribute(a, 0) = attr[a]->dsample(this, global::abstime);
         }
     }
     
@@ -73,13 +78,15 @@ Ageable::Ageable(Creator *_creator)
 
 Ageable::~Ageable()
 {
-    for(Attribute attr = 0; 
-        attr < creator->getCollector()->getNumberOfAttributes(); attr++) {
-        if (attrfixed && attrfixed[attr]) delete[] attrfixed[attr];
-    }
     if (attrfixed) delete[] attrfixed;
 }
 
+Number Ageable::getNumberOfFixedValues() const
+{
+    return(attrfixedperbinpos + 
+        creator->getCollector()->getNumberOfFixedAttributes(true)*binnum);
+}
+
 Number Ageable::getNumber(NumberOf what) const
 { 
     switch(what) {
@@ -97,7 +104,12 @@ Number Ageable::getNumber(NumberOf what) const
 Value Ageable::getAttribute(Attribute a, Time now) const
 {
     if (attrisfixed[a]) { 
-        return(attrfixed[a][bin]);
+        return(getFixedAttribute(a, bin));
+    } else if (attrcache[a]) {
+        // deterministic given type and bin; evaluate only once
+        Value &v = attrcache[a][getBinLinearised()];
+        if (ISNAN(v)) v = attr[a]->dsample(this, now);
+        return(v);
     } else { 
         return(attr[a]->dsample(this, now));
     }
@@ -106,13 +118,13 @@ Value Ageable::getAttribute(Attribute a, Time now) const
 Value Ageable::getAttribute(Attribute a, Time now, Value atleast) const
 {
     if (attrisfixed[a]) {
-        if (atleast > attrfixed[a][bin]) {    
+        if (atleast > getFixedAttribute(a, bin)) {    
             rif_error(creator->getCfg(), 
 "trying to condition on attribute that was fixed at birth, but conditioning\
 value is bigger than attribute");
             return(0);
         } else {
-            return(attrfixed[a][bin]-atleast);
+            return(getFixedAttribute(a, bin)-atleast);
         };
     } else { 
         return(attr[a]->dsample(this, now, atleast));
@@ -164,13 +176,13 @@ attr++) {
             if (collection->getAttributesIsFixedPerBinArray()[attr]) {
                 s << "(fixedperbin)=(";
                 for (Bin b = 0; b < binnum; b++) {
-                    s << attrfixed[attr][b] << ",";
+                    s << getFixedAttribute(attr, b) << ",";
                 }
                 int pos = s.tellp();
                 s.seekp(pos-1);
                 s << ")";
             } else if (attrisfixed[attr]) {
-                s << "(fixed)=" << attrfixed[attr][0];
+                s << "(fixed)=" << getFixedAttribute(attr, 0);
             } else {
                 s << "(random)";
             }
@@ -230,6 +242,33 @@ BinChange Ageable::sampleBinChange(Bin from, Time now, bool conditional)
     bc.reltime = MAXDOUBLE;
     bc.from = from;
     bc.to = BINNA;
+    
+    const int *out = creator->bintransout[from];
+    int outnum = creator->bintransoutnum[from];
+    
+    if (outnum == 0) return(bc);
+    
+    double totalrate = creator->bintransoutrate[from];
+    if (totalrate >= 0) {
+        // all competing transitions are exponential; the first of them
+        // happens after an exponential time with the total rate and it is
+        // transition 'trans' with probability rate(trans)/totalrate; as the
+        // exponential distribution is memoryless, this holds for conditional
+        // sampling as well
+        if (totalrate == 0.0) return(bc);
+        unsigned int randcore = creator->bintransdist[out[0]]->getRandcore();
+        bc.reltime = -log(ran::dran(randcore))/totalrate;
+        double u = ran::dran(randcore)*totalrate;
+        for (int k = 0; k < outnum; k++) {
+            double rate = ((DistributionExponential*)
+                creator->bintransdist[out[k]])->getRate();
+            if (rate == 0.0) continue;
+            bc.to = creator->bintransto[out[k]];
+            if (u < rate) break;
+            u -= rate;
+        }
+        return(bc);
+    }
         
     if (conditional) {
         Time timediff = now - procBinChange.lastTime();
@@ -239,26 +278,24 @@ BinChange Ageable::sampleBinChange(Bin from, Time now, bool conditional)
 later than now"
             );
         }
-        for (int trans = 0; trans < creator->bintransnum; trans++) {
-            if (creator->bintransfrom[trans] == from) {
-                double nexttime = 
-                    creator->bintransdist[trans]->
-                    dsample(this, procBinChange.lastTime(),timediff);
-                if (nexttime > 0 && nexttime < bc.reltime) {
-                    bc.reltime = nexttime;
-                    bc.to = creator->bintransto[trans];
-                }
+        for (int k = 0; k < outnum; k++) {
+            int trans = out[k];
+            double nexttime = 
+                creator->bintransdist[trans]->
+                dsample(this, procBinChange.lastTime(),timediff);
+            if (nexttime > 0 && nexttime < bc.reltime) {
+                bc.reltime = nexttime;
+                bc.to = creator->bintransto[trans];
             }
         }
     } else {
-        for (int trans = 0; trans < creator->bintransnum; trans++) {
-            if (creator->bintransfrom[trans] == from) {
-                Time nexttime = 
-                    creator->bintransdist[trans]->dsample(this, now);
-                if (nexttime > 0 && nexttime < bc.reltime) {
-                    bc.reltime = nexttime;
-                    bc.to = creator->bintransto[trans];
-                }
+        for (int k = 0; k < outnum; k++) {
+            int trans = out[k];
+            Time nexttime = 
+                creator->bintransdist[trans]->dsample(this, now);
+            if (nexttime > 0 && nexttime < bc.reltime) {
+                bc.reltime = nexttime;
+                bc.to = creator->bintransto[trans];
             }
         }
     }
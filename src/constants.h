@@ -113,6 +113,10 @@ used to represent a generic subclass of the classes in the following list. */
     #define CLASSEVENTTREAT                     43
 /** A constant for object::idsubclass */
     #define CLASSEVENTPROVOKEVISITGP      44
+/** A constant for object::idsubclass */
+    #define CLASSEVENTTRANSMISSION              45
+/** A constant for object::idsubclass */
+    #define CLASSEVENTSCREENING                 46
 
 /** A constant for object::idclass */
 #define CLASSDISTRIBUTION               50
@@ -793,12 +793,42 @@ Distribution *_createDistribution(ROBJ cfg, const CreatorCollection *collection)
 }
 
 
+// Lowers a freshly created distribution tree. As the children of an array are
+// created through createDistribution as well, the tree is compiled bottom-up:
+// 'product' and 'sum' nodes over constants are folded into a single value,
+// lookups (by bin, type, number of partners, ...) over constants become flat
+// tables, and lookups whose entries are all the same constant are replaced by 
+// a DistributionConstant altogether. What remains of the tree is then lowered
+// into a DistributionProgram for its root; a subtree that was lowered as the
+// child of an array gives its program up when the parent is lowered, so that
+// only the outermost one is kept.
+Distribution *compileDistribution(Distribution *d)
+{
+    if (d->idsubclass == CLASSDISTRIBUTIONARRAY) {
+        DistributionArray *a = (DistributionArray*)d;
+        a->compile();
+        
+        double value;
+        if (a->isUniformLookup(value)) {
+            Distribution *c = new DistributionConstant(
+                INTNA, a->getCfg(), NoConditioning, value);
+            delete a;
+            return(c);
+        }
+    }
+    
+    DistributionProgram *program = new DistributionProgram();
+    d->emit(*program);
+    if (!program->isValid() || !d->setProgram(program)) delete program;
+    return(d);
+}
+
 Distribution *createDistribution(ROBJ cfg, const Creator *creator)
 {
     ROBJ cfg_dist = rif_trylookup(cfg, "distribution");
     if (!rif_isNull(cfg_dist)) return(createDistribution(cfg_dist,creator));
     
-    Distribution *d = _createDistribution(cfg, creator);
+    Distribution *d = compileDistribution(_createDistribution(cfg, creator));
 //     d->print();
     return(d);
 }
@@ -808,7 +838,7 @@ Distribution *createDistribution(ROBJ cfg, const CreatorCollection *collection)
     ROBJ cfg_dist = rif_trylookup(cfg, "distribution");
     if (!rif_isNull(cfg_dist)) return(createDistribution(cfg_dist,collection));
     
-    Distribution *d = _createDistribution(cfg, collection);
+    Distribution *d = compileDistribution(_createDistribution(cfg, collection));
 //     d->print();
     return(d);
 }
@@ -52,6 +52,9 @@ Creator::Creator(
     bintransfrom = 0;
     bintransto = 0;
     bintransdist = 0;
+    bintransoutnum = 0;
+    bintransout = 0;
+    bintransoutrate = 0;
     
     // get the bin configuration part
     ROBJ cfg_bins = rif_trylookup(cfg,"bins");
@@ -136,6 +139,36 @@ Creator::Creator(
                 createDistribution(rif_lookup(cfg_thistrans,"at"), this);
         }
     }
+    
+    // sort the transitions by the bin they are going out of
+    bintransoutnum = new Number[binnum];
+    bintransout = new int*[binnum];
+    bintransoutrate = new double[binnum];
+    for (Bin bin = 0; bin < binnum; bin++) {
+        bintransoutnum[bin] = 0;
+        for (int trans = 0; trans < bintransnum; trans++) {
+            if (bintransfrom[trans] == bin) bintransoutnum[bin]++;
+        }
+        bintransout[bin] = new int[bintransoutnum[bin]];
+        // if all outgoing transitions are plain exponentials, the next
+        // transition can be sampled from the total rate (see
+        // Ageable::sampleBinChange())
+        bintransoutrate[bin] = 0.0;
+        int k = 0;
+        for (int trans = 0; trans < bintransnum; trans++) {
+            if (bintransfrom[trans] != bin) continue;
+            bintransout[bin][k++] = trans;
+            if (bintransoutrate[bin] < 0) continue;
+            if (bintransdist[trans]->idsubclass == CLASSDISTRIBUTIONEXPONENTIAL
+                && ((DistributionExponential*)bintransdist[trans])
+                    ->isMemoryless()) {
+                bintransoutrate[bin] += 
+                    ((DistributionExponential*)bintransdist[trans])->getRate();
+            } else {
+                bintransoutrate[bin] = -1.0;
+            }
+        }
+    }
 }
 
 Creator::~Creator()
@@ -150,6 +183,12 @@ Creator::~Creator()
             delete bintransdist[trans];
     }
     if (bintransdist) delete[] bintransdist;
+    for (Bin bin = 0; bin < binnum; bin++) {
+        if (bintransout && bintransout[bin]) delete[] bintransout[bin];
+    }
+    if (bintransout) delete[] bintransout;
+    if (bintransoutnum) delete[] bintransoutnum;
+    if (bintransoutrate) delete[] bintransoutrate;
 }
     
 string Creator::str() const
@@ -399,7 +438,9 @@ Attribute Creator::installAttribute(
         if (collection->getAttributesIsFixedPerBinArray()[attr]) 
             if (!global::keepquiet) Rprintf(" per bin");
         if (!global::keepquiet) Rprintf(")");
-    } 
+    } else if (collection->getAttributesPurityArray()[attr] <= PurityTypeBin) {
+        if (!global::keepquiet) Rprintf("(cached)");
+    }
     if (settodefault) 
         if (!global::keepquiet) Rprintf(" (set to default: %f)", defaultval);
     if (!global::keepquiet) Rprintf("\n");
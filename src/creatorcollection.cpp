@@ -58,8 +58,13 @@ CreatorCollection::CreatorCollection(
         }
     }
     attrnum = 0;
-    for (int i = 0; i < MAXNEWATTRIBUTES; i++) 
+    attrfixednum = 0;
+    attrfixedperbinnum = 0;
+    attrcacheready = false;
+    for (int i = 0; i < MAXNEWATTRIBUTES; i++) {
         attr[i] = 0;
+        attrcache[i] = 0;
+    }
         
     // ...get the number of types that will be installed (i.e. that will
     // register themselves later
@@ -90,6 +95,7 @@ void CreatorCollection::preDelete()
     // delete all attribute distributions
     for (int i = 0; i < attrnum; i++) {
         if (attr[i]) delete attr[i];
+        if (attrcache[i]) delete[] attrcache[i];
     }
     // delete the distribution used by for getRandomCreator()
     if (dist) delete dist;
@@ -113,6 +119,14 @@ Attribute CreatorCollection::installAttribute(
     // see if this attribute is fixed at birth 
     attrisfixed[a] = 
         attrisfixedperbin[a] || rif_exists(cfg, "fixatbirth") ? true : false;
+    // give it its place in the fixed values of the ageables
+    if (attrisfixedperbin[a]) {
+        attrfixedindex[a] = attrfixedperbinnum++;
+    } else if (attrisfixed[a]) {
+        attrfixedindex[a] = attrfixednum++;
+    } else {
+        attrfixedindex[a] = INTNA;
+    }
     // see if a reference creator is given
     if (creator) {
         // if yes, evaluate with respect to that creator ('bytype' not allowed)
@@ -121,6 +135,9 @@ Attribute CreatorCollection::installAttribute(
         // if not, evaluate with respect to this collection ('bytype' allowed)
         attr[a] = createDistribution(cfg, this);
     }
+    // classify the attribute; if it is a function of type and bin only it
+    // will be cached (see getAttributesCacheArray())
+    attrpurity[a] = attr[a]->getPurity();
     return(a);
 }
 
@@ -239,12 +256,50 @@ const bool *CreatorCollection::getAttributesIsFixedPerBinArray() const
 {
     return(attrisfixedperbin);
 };
+
+const int *CreatorCollection::getAttributesFixedIndexArray() const
+{
+    return(attrfixedindex);
+};
+
+Number CreatorCollection::getNumberOfFixedAttributes(bool perbin) const
+{
+    return(perbin ? attrfixedperbinnum : attrfixednum);
+};
         
 const Distribution * const *CreatorCollection::getAttributesArray() const
 {
     return(attr);
 };
         
+const Purity *CreatorCollection::getAttributesPurityArray() const
+{
+    return(attrpurity);
+};
+
+Value * const *CreatorCollection::getAttributesCacheArray()
+{
+    if (!attrcacheready) {
+        for (Attribute a = 0; a < attrnum; a++) {
+            // fixed attributes have their own cache in the Ageable
+            if (attrisfixed[a] || attrpurity[a] > PurityTypeBin) continue;
+            attrcache[a] = new Value[len];
+            for (int i = 0; i < len; i++) attrcache[a][i] = NA_REAL;
+        }
+        attrcacheready = true;
+    }
+    return(attrcache);
+};
+        
+Number CreatorCollection::getNumberOfCachedValues() const
+{
+    Number n = 0;
+    for (Attribute a = 0; a < attrnum; a++) {
+        if (attrcache[a]) n += len;
+    }
+    return(n);
+};
+
 const Distribution *CreatorCollection::getAttribute(Attribute a) const
 {
     return(attr[a]);
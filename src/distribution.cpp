@@ -21,6 +21,7 @@
 
 #include <cmath>
 #include <sstream>
+#include <algorithm>
 
 #include "constants.h"
 #include "rangen.h"
@@ -226,6 +227,20 @@ atleast) const
     return(0.0); // Should never be reached
 }
 
+Purity Distribution::getPurity() const
+{
+    return(PurityStochastic);
+}
+
+void Distribution::emit(DistributionProgram &program)
+{
+    if (isConstant() && cond == NoConditioning) {
+        program.pushConstant(dsample(), isample());
+    } else {
+        program.pushLeaf(this, cond == NoConditioning);
+    }
+}
+
 void Distribution::checkRange(double min, double max) const
 {
     if (idsubclass == CLASSGENERIC) {
@@ -329,6 +344,15 @@ double DistributionExponential::dsample() const
     return(min(dminx-log(ran::dran(randcore))/rate,dmaxx));
 }
 
+void DistributionExponential::emit(DistributionProgram &program)
+{
+    if (cond != NoConditioning) {
+        Distribution::emit(program);
+        return;
+    }
+    program.pushExponential(this, rate, dminx, dmaxx);
+}
+
 double DistributionExponential::dsample(double atleast) const
 {
     if (atleast > dmaxx) 
@@ -364,6 +388,11 @@ double DistributionExponential::dsamplefac(double factor, double atleast) const
     
 }
 
+bool DistributionExponential::isMemoryless() const
+{
+    return(cond == NoConditioning && dminx == 0.0 && dmaxx == MAXDOUBLE);
+}
+
 string DistributionExponential::str() const
 {
     ostringstream s;
@@ -688,6 +717,14 @@ double DistributionConstantContinuous::dsample(double atleast) const
     }
 }
 
+Purity DistributionConstantContinuous::getPurity() const
+{
+    // the interpolation is deterministic; only the point where it is 
+    // evaluated may change
+    if (cond == NoConditioning) return(PurityConstant);
+    return(PurityAge);
+}
+
 string DistributionConstantContinuous::str() const
 {
     ostringstream s;
@@ -981,6 +1018,12 @@ DistributionArray::DistributionArray(ROBJ cfg, const Creator *creator)
 {
     idsubclass = CLASSDISTRIBUTIONARRAY;
     array = 0;    
+    folded = false;
+    dfolded = 0.0;
+    ifolded = 0;
+    dtable = 0;
+    itable = 0;
+    program = 0;
     dminx = 0;
     dmaxx = 0;
     min = 0;
@@ -1094,6 +1137,12 @@ DistributionArray::DistributionArray(ROBJ cfg, const CreatorCollection
 {
     idsubclass = CLASSDISTRIBUTIONARRAY;
     array = 0;    
+    folded = false;
+    dfolded = 0.0;
+    ifolded = 0;
+    dtable = 0;
+    itable = 0;
+    program = 0;
         
     getWhatMinLen(cfg, what, min, len, collection, true);
     
@@ -1200,10 +1249,184 @@ DistributionArray::~DistributionArray()
             if (array[i]) delete array[i];
         delete[] array;
     }
+    if (dtable) delete[] dtable;
+    if (itable) delete[] itable;
+    if (program) delete program;
+}
+
+void DistributionArray::compile()
+{
+    if (folded || dtable) return; // already compiled
+    
+    for (unsigned int i = min; i < len; i++) {
+        if (!array[i] || !array[i]->isConstant()) return;
+    }
+    
+    switch(what) {
+        case NumberProduct: {
+            double dres = 1;
+            double ires = 1;
+            for (unsigned int i = min; i < len; i++) {
+                dres *= array[i]->dsample();
+                ires *= array[i]->isample();
+            }
+            dfolded = dres;
+            ifolded = (int)ires;
+            folded = true;
+            break;
+        }
+        case NumberSum: {
+            double dres = 0;
+            double ires = 0;
+            for (unsigned int i = min; i < len; i++) {
+                dres += array[i]->dsample();
+                ires += array[i]->isample();
+            }
+            dfolded = dres;
+            ifolded = (int)ires;
+            folded = true;
+            break;
+        }
+        default : {
+            dtable = new double[len];
+            itable = new int[len];
+            for (unsigned int i = 0; i < len; i++) {
+                dtable[i] = 0.0;
+                itable[i] = 0;
+            }
+            for (unsigned int i = min; i < len; i++) {
+                dtable[i] = array[i]->dsample();
+                itable[i] = array[i]->isample();
+            }
+        }
+    }
+}
+
+bool DistributionArray::isUniformLookup(double &value) const
+{
+    if (!dtable || (unsigned int)min >= len) return(false);
+    value = dtable[min];
+    for (unsigned int i = min; i < len; i++) {
+        if (dtable[i] != value || itable[i] != (int)floor(value)) 
+            return(false);
+    }
+    return(true);
+}
+
+bool DistributionArray::isZeroInBin(Bin bin) const
+{
+    if (folded) return(dfolded == 0.0);
+    switch(what) {
+        case NumberProduct: 
+            for (unsigned int i = min; i < len; i++)
+                if (array[i] && array[i]->isZeroInBin(bin)) return(true);
+            return(false);
+        case NumberSum: 
+            return(false);
+        case NumberOfBin: {
+            unsigned int index = bin;
+            if (index >= len) {
+                index = len-1;
+            } else if ((int)index < min) {
+                index = min;
+            }
+            return(array[index] && array[index]->isZeroInBin(bin));
+        }
+        default :
+            // any entry may be used
+            for (unsigned int i = min; i < len; i++)
+                if (!array[i] || !array[i]->isZeroInBin(bin)) return(false);
+            return(true);
+    }
+}
+
+Purity DistributionArray::getPurity() const
+{
+    if (folded) return(PurityConstant);
+    
+    Purity purity = PurityConstant;
+    for (unsigned int i = min; i < len; i++) {
+        if (!array[i]) continue;
+        purity = max(purity, array[i]->getPurity());
+    }
+    
+    switch(what) {
+        case NumberProduct: 
+        case NumberSum: 
+            return(purity);
+        case NumberOfBin: 
+        case NumberOfType: 
+            return(max(purity, PurityTypeBin));
+        default :
+            return(max(purity, PurityState));
+    }
+}
+
+void DistributionArray::emit(DistributionProgram &p)
+{
+    // inlined into the program of the parent, the own one is not needed
+    if (program) delete program;
+    program = 0;
+    
+    if (folded) {
+        p.pushConstant(dfolded, ifolded);
+        return;
+    }
+    if (dtable) {
+        p.pushTable(this);
+        return;
+    }
+    switch(what) {
+        case NumberProduct: 
+        case NumberSum: {
+            for (unsigned int i = min; i < len; i++) 
+                array[i]->emit(p);
+            if (what == NumberProduct) {
+                p.pushProduct(len - min);
+            } else {
+                p.pushSum(len - min);
+            }
+            break;
+        }
+        default : {
+            unsigned int lookup = p.beginLookup(this);
+            for (unsigned int i = min; i < len; i++) {
+                p.beginBranch(lookup, i);
+                array[i]->emit(p);
+                p.endBranch(lookup);
+            }
+            p.endLookup(lookup);
+        }
+    }
+}
+
+bool DistributionArray::setProgram(DistributionProgram *p)
+{
+    // folded arrays and tables are not faster as a program
+    if (folded || dtable) return(false);
+    if (program) delete program;
+    program = p;
+    return(true);
+}
+
+int DistributionArray::lookupIndex(const Ageable *obj) const
+{
+    int index = obj->getNumber(what);
+    if (index < 0) {
+        rif_error(cfg,
+    "internal distribution.cpp: getNumber returned negative value",__LINE__);
+    }
+    if ((unsigned int)index >= len) {
+        index = len-1;
+    } else if (index < min) {
+        index = min;
+    }
+    return(index);
 }
     
 double DistributionArray::dsample() const
 {
+    if (folded) return(dfolded);
     switch(what) {
         case NumberProduct: {
             double res = 1;
@@ -1242,6 +1465,9 @@ double DistributionArray::dsample(double atleast) const
 
 double DistributionArray::dsample(const Ageable *obj, double now) const
 {
+    if (program) return(program->dsample(obj, now));
+    if (folded) return(dfolded);
+    if (dtable) return(dtable[lookupIndex(obj)]);
     switch(what) {
         case NumberProduct: {
             double res = 1;
@@ -1255,19 +1481,8 @@ double DistributionArray::dsample(const Ageable *obj, double now) const
                 res += array[i]->dsample(obj, now);
             return(res);
         }
-        default : {    
-            int index = obj->getNumber(what);
-            if (index < 0) {
-                rif_error(cfg,
-        "internal distribution.cpp: getNumber returned negative value",__LINE__);
-            }
-            if ((unsigned int)index >= len) {
-                index = len-1;
-            } else if (index < min) {
-                index = min;
-            }
-            return(array[index]->dsample(obj, now));
-        }
+        default :
+            return(array[lookupIndex(obj)]->dsample(obj, now));
     }
         
 }
@@ -1289,24 +1504,14 @@ const
                 res += array[i]->dsample(obj, now, atleast);
             return(res);
         }
-        default : {    
-            int index = obj->getNumber(what);
-            if (index < 0) {
-                rif_error(cfg,
-        "internal distribution.cpp: getNumber returned negative value",__LINE__);
-            }
-            if ((unsigned int)index >= len) {
-                index = len-1;
-            } else if (index < min) {
-                index = min;
-            }
-            return(array[index]->dsample(obj, now, atleast));
-        }
+        default :
+            return(array[lookupIndex(obj)]->dsample(obj, now, atleast));
     }
 }
 
 int DistributionArray::isample() const
 {
+    if (folded) return(ifolded);
     switch(what) {
         case NumberProduct: {
             double res = 1;
@@ -1349,6 +1554,9 @@ int DistributionArray::isample(double atleast) const
 
 int DistributionArray::isample(const Ageable *obj, double now) const
 {
+    if (program) return(program->isample(obj, now));
+    if (folded) return(ifolded);
+    if (itable) return(itable[lookupIndex(obj)]);
     switch(what) {
         case NumberProduct: {
             double res = 1;
@@ -1362,19 +1570,8 @@ int DistributionArray::isample(const Ageable *obj, double now) const
                 res += array[i]->isample(obj, now);
             return(res);
         }
-        default : {    
-            int index = obj->getNumber(what);
-            if (index < 0) {
-                rif_error(cfg,
-        "internal distribution.cpp: getNumber returned negative value",__LINE__);
-            }
-            if ((unsigned int)index >= len) {
-                index = len-1;
-            } else if (index < min) {
-                index = min;
-            }
-            return(array[index]->isample(obj, now));
-        }
+        default :
+            return(array[lookupIndex(obj)]->isample(obj, now));
     }
 }
 
@@ -1394,19 +1591,8 @@ const
                 res += array[i]->isample(obj, now, atleast);
             return(res);
         }
-        default : {    
-            int index = obj->getNumber(what);
-            if (index < 0) {
-                rif_error(cfg,
-        "internal distribution.cpp: getNumber returned negative value",__LINE__);
-            }
-            if ((unsigned int)index >= len) {
-                index = len-1;
-            } else if (index < min) {
-                index = min;
-            }
-            return(array[index]->isample(obj, now, atleast));
-        }
+        default :
+            return(array[lookupIndex(obj)]->isample(obj, now, atleast));
     }
 }
 
@@ -1469,19 +1655,8 @@ const
                 res += array[i]->dsamplefac(factor, obj, now);
             return(res);
         }
-        default : {    
-            int index = obj->getNumber(what);
-            if (index < 0) {
-                rif_error(cfg,
-        "internal distribution.cpp: getNumber returned negative value",__LINE__);
-            }
-            if ((unsigned int)index >= len) {
-                index = len-1;
-            } else if (index < min) {
-                index = min;
-            }
-            return(array[index]->dsamplefac(factor,obj, now));
-        }
+        default :
+            return(array[lookupIndex(obj)]->dsamplefac(factor,obj, now));
     }
 }
 
@@ -1502,19 +1677,9 @@ double atleast) const
                 res += array[i]->dsamplefac(factor, obj, now, atleast);
             return(res);
         }
-        default : {    
-            int index = obj->getNumber(what);
-            if (index < 0) {
-                rif_error(cfg,
-        "internal distribution.cpp: getNumber returned negative value",__LINE__);
-            }
-            if ((unsigned int)index >= len) {
-                index = len-1;
-            } else if (index < min) {
-                index = min;
-            }
-            return(array[index]->dsamplefac(factor,obj, now, atleast));
-        }
+        default :
+            return(array[lookupIndex(obj)]->dsamplefac(
+                factor, obj, now, atleast));
     }
 }
 
@@ -1524,7 +1689,10 @@ string DistributionArray::str() const
     ostringstream s;
     s << "DistributionArray:"
         << "length=" << len
-        << ",what=" << what,
+        << ",what=" << what
+        << ",folded=" << folded
+        << ",table=" << (dtable != 0)
+        << ",program=" << (program ? program->size() : 0);
     s << "|" << Distribution::str();
     for (unsigned int i = min; i < len; i++) {
         s << endl << "\t";
@@ -1550,12 +1718,14 @@ DistributionHost::DistributionHost(ROBJ cfg, const CreatorCollection
 {
     hostcollection = _hostcollection;
     dist = 0;
+    program = 0;
     dist = createDistribution(rif_lookup(cfg,"host"),hostcollection);
 }
 
 DistributionHost::~DistributionHost()
 {
     if (dist) delete dist;
+    if (program) delete program;
 }
     
 double DistributionHost::dsample() const
@@ -1566,6 +1736,7 @@ double DistributionHost::dsample() const
 
 int DistributionHost::isample(const Ageable *obj, double now) const
 {
+    if (program) return(program->isample(obj, now));
     if (obj->idclass == CLASSINFECTION) {
         return(dist->isample(((Infection*)obj)->getHost(),now));
     } else {
@@ -1587,6 +1758,7 @@ const
     
 double DistributionHost::dsample(const Ageable *obj, double now) const
 {
+    if (program) return(program->dsample(obj, now));
     if (obj->idclass == CLASSINFECTION) {
         return(dist->dsample(((Infection*)obj)->getHost(),now));
     } else {
@@ -1631,6 +1803,32 @@ atleast));
     }
 }
 
+void DistributionHost::emit(DistributionProgram &p)
+{
+    // see DistributionArray::emit()
+    if (program) delete program;
+    program = 0;
+    
+    p.beginHost(this);
+    dist->emit(p);
+    p.endHost();
+}
+
+bool DistributionHost::setProgram(DistributionProgram *p)
+{
+    if (program) delete program;
+    program = p;
+    return(true);
+}
+
+Purity DistributionHost::getPurity() const
+{
+    Purity purity = dist->getPurity();
+    // anything but a constant depends on who the host is
+    if (purity == PurityConstant) return(purity);
+    return(max(purity, PurityState));
+}
+
 string DistributionHost::str() const
 {
     ostringstream s;
@@ -1689,6 +1887,15 @@ double DistributionUniform::dsample() const
     return(ran::dran(randcore,dminx,dmaxx));
 }
 
+void DistributionUniform::emit(DistributionProgram &program)
+{
+    if (cond != NoConditioning) {
+        Distribution::emit(program);
+        return;
+    }
+    program.pushUniform(this, dminx, dmaxx);
+}
+
 double DistributionUniform::dsample(double atleast) const
 {
     if (atleast > dmaxx)
@@ -1709,3 +1916,243 @@ string DistributionUniform::str() const
 
 }
 
+DistributionProgram::DistributionProgram()
+{
+    depth = maxdepth = 0;
+    hosts = maxhosts = 0;
+    lookupend = 0;
+}
+
+DistributionProgram::Instruction &DistributionProgram::append(OpCode op)
+{
+    Instruction in;
+    in.op = op;
+    in.next = code.size() + 1;
+    in.dist = 0;
+    in.array = 0;
+    in.dvalue = in.lower = in.upper = 0.0;
+    in.ivalue = 0;
+    in.randcore = 0;
+    in.count = 0;
+    in.target = 0;
+    in.depth = 0;
+    code.push_back(in);
+    return(code.back());
+}
+
+void DistributionProgram::push()
+{
+    depth++;
+    if (depth > maxdepth) maxdepth = depth;
+}
+
+void DistributionProgram::pushConstant(double dvalue, int ivalue)
+{
+    Instruction &in = append(OpConstant);
+    in.dvalue = dvalue;
+    in.ivalue = ivalue;
+    push();
+}
+
+void DistributionProgram::pushLeaf(const Distribution *leaf, bool plain)
+{
+    append(plain ? OpLeafPlain : OpLeaf).dist = leaf;
+    push();
+}
+
+void DistributionProgram::pushExponential(const Distribution *leaf, 
+    double rate, double shift, double cutat)
+{
+    Instruction &in = append(OpExponential);
+    in.dist = leaf;
+    in.randcore = leaf->getRandcore();
+    in.dvalue = rate;
+    in.lower = shift;
+    in.upper = cutat;
+    push();
+}
+
+void DistributionProgram::pushUniform(const Distribution *leaf, 
+    double min, double max)
+{
+    Instruction &in = append(OpUniform);
+    in.dist = leaf;
+    in.randcore = leaf->getRandcore();
+    in.lower = min;
+    in.upper = max;
+    push();
+}
+
+void DistributionProgram::pushTable(const DistributionArray *array)
+{
+    append(OpTable).array = array;
+    push();
+}
+
+void DistributionProgram::pushProduct(unsigned int count)
+{
+    append(OpProduct).count = count;
+    depth -= count;
+    push();
+}
+
+void DistributionProgram::pushSum(unsigned int count)
+{
+    append(OpSum).count = count;
+    depth -= count;
+    push();
+}
+
+unsigned int DistributionProgram::beginLookup(const DistributionArray *array)
+{
+    Instruction &in = append(OpLookup);
+    in.array = array;
+    in.target = targets.size();
+    in.depth = depth;
+    // indices below the minimum are never used, see lookupIndex()
+    targets.resize(targets.size() + array->len, 0);
+    return(code.size() - 1);
+}
+
+void DistributionProgram::beginBranch(unsigned int lookup, unsigned int index)
+{
+    targets[code[lookup].target + index] = code.size();
+    depth = code[lookup].depth;
+}
+
+void DistributionProgram::endBranch(unsigned int lookup)
+{
+    // the end of the branch continues after the lookup, which is set by
+    // endLookup(); the instructions are chained by their position plus one
+    if (lookupend == code.size()) append(OpJump);
+    code.back().next = code[lookup].count;
+    code[lookup].count = code.size();
+}
+
+void DistributionProgram::endLookup(unsigned int lookup)
+{
+    unsigned int end = code.size();
+    unsigned int chained = code[lookup].count;
+    while (chained) {
+        unsigned int previous = code[chained - 1].next;
+        code[chained - 1].next = end;
+        chained = previous;
+    }
+    code[lookup].count = 0;
+    lookupend = end;
+    depth = code[lookup].depth;
+    push();
+}
+
+void DistributionProgram::beginHost(const Distribution *host)
+{
+    append(OpHost).dist = host;
+    hosts++;
+    if (hosts > maxhosts) maxhosts = hosts;
+}
+
+void DistributionProgram::endHost()
+{
+    append(OpHostEnd);
+    hosts--;
+}
+
+bool DistributionProgram::isValid() const
+{
+    return(depth == 1 && hosts == 0 && 
+        maxdepth <= MAXDEPTH && maxhosts <= MAXDEPTH);
+}
+
+double DistributionProgram::dsample(const Ageable *obj, double now) const
+{
+    return(run<false>(obj, now));
+}
+
+int DistributionProgram::isample(const Ageable *obj, double now) const
+{
+    return((int)run<true>(obj, now));
+}
+
+template<bool integer> 
+double DistributionProgram::run(const Ageable *obj, double now) const
+{
+    // in integer mode the values are the results of isample(), and products
+    // and sums are truncated as in DistributionArray::isample()
+    double stack[MAXDEPTH];
+    const Ageable *objects[MAXDEPTH];
+    int top = 0;
+    int nested = 0;
+    
+    const Instruction *start = &code[0];
+    const Instruction *end = start + code.size();
+    const Instruction *in = start;
+    while (in != end) {
+        switch(in->op) {
+            case OpConstant: 
+                stack[top++] = integer ? in->ivalue : in->dvalue;
+                break;
+            case OpLeaf: 
+                stack[top++] = integer ? in->dist->isample(obj, now) : 
+                    in->dist->dsample(obj, now);
+                break;
+            case OpLeafPlain: 
+                stack[top++] = integer ? in->dist->isample() : 
+                    in->dist->dsample();
+                break;
+            case OpExponential: 
+                if (integer) {
+                    stack[top++] = in->dist->isample();
+                } else if (in->dvalue == 0.0) {
+                    stack[top++] = in->upper;
+                } else {
+                    stack[top++] = min(in->lower - 
+                        log(ran::dran(in->randcore))/in->dvalue, in->upper);
+                }
+                break;
+            case OpUniform: 
+                stack[top++] = integer ? in->dist->isample() :
+                    ran::dran(in->randcore, in->lower, in->upper);
+                break;
+            case OpTable: {
+                int index = in->array->lookupIndex(obj);
+                stack[top++] = integer ? in->array->itable[index] : 
+                    in->array->dtable[index];
+                break;
+            }
+            case OpProduct: {
+                top -= in->count;
+                double res = 1;
+                for (unsigned int i = 0; i < in->count; i++) 
+                    res *= stack[top + i];
+                stack[top++] = integer ? (int)res : res;
+                break;
+            }
+            case OpSum: {
+                top -= in->count;
+                double res = 0;
+                for (unsigned int i = 0; i < in->count; i++) 
+                    res += stack[top + i];
+                stack[top++] = integer ? (int)res : res;
+                break;
+            }
+            case OpLookup: 
+                in = start + targets[in->target + in->array->lookupIndex(obj)];
+                continue;
+            case OpJump: 
+                break;
+            case OpHost: 
+                if (obj->idclass != CLASSINFECTION) {
+                    rif_error(in->dist->getCfg(), 
+                        "cannot get host from non-infection object");
+                }
+                objects[nested++] = obj;
+                obj = ((Infection*)obj)->getHost();
+                break;
+            case OpHostEnd: 
+                obj = objects[--nested];
+                break;
+        }
+        in = start + in->next;
+    }
+    return(stack[0]);
+}
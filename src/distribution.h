@@ -21,8 +21,13 @@
 #ifndef DISTRIBUTION_H
 #define DISTRIBUTION_H
 
+#include <vector>
+
 #include "object.h"
 
+class DistributionProgram;
+class DistributionArray;
+
 /*****************************************************************************
 These two function create a new distribution. They differ in the second
 argument which defines the context of how the distribution will be used. There
@@ -95,11 +100,36 @@ public:
     
     virtual int isamplemax(int max) const;
     
+    // True if every sample (without conditioning) gives the same value; 
+    // used by createDistribution to fold constant subtrees
+    virtual bool isConstant() const { return(false); };
+    
+    // True if every sample for an object in the given bin is 0 (of the
+    // Creator the distribution was installed for); false if unknown
+    virtual bool isZeroInBin(Bin /*bin*/) const 
+        { return(isConstant() && dsample() == 0.0); };
+    
+    // Classifies what the samples of this distribution depend on; see the
+    // Purity enum in typedefs.h
+    virtual Purity getPurity() const;
+    
+    // Appends the instructions that evaluate this distribution to 'program';
+    // a leaf is sampled through its own functions, constants are inlined
+    virtual void emit(DistributionProgram &program);
+    // Installs the program of the tree below this distribution, which is then
+    // used by dsample(obj, now) and isample(obj, now); false if this
+    // distribution does not use one, the caller then deletes it
+    virtual bool setProgram(DistributionProgram * /*program*/) 
+        { return(false); };
+    
     int    getiminx() const {return(iminx);};
     int    getimaxx() const {return(imaxx);};
     double getdminx() const {return(dminx);};
     double getdmaxx() const {return(dmaxx);};
     
+    ROBJ getCfg() const {return(cfg);};
+    unsigned int getRandcore() const {return(randcore);};
+    
     std::string str() const;
 
 protected:
@@ -123,6 +153,9 @@ public:
     double dsample() const;
     double dsample(double atleast) const;
     
+    bool isConstant() const { return(true); };
+    Purity getPurity() const { return(PurityConstant); };
+    
     std::string str() const;
 };
 
@@ -138,6 +171,14 @@ cond,
    
     double dsamplefac(double factor) const;
     double dsamplefac(double factor, double atleast) const; 
+    
+    // True if this is a plain exponential distribution (no shift, no cut
+    // point, no conditioning), so that it can be combined with other such
+    // distributions into a single competing hazard
+    bool isMemoryless() const;
+    double getRate() const { return(rate); };
+    
+    void emit(DistributionProgram &program);
    
     std::string str() const;
     
@@ -173,6 +214,8 @@ public:
     int isamplemax(int max) const;
     double dsample() const;
     double dsample(double atleast) const;
+    
+    void emit(DistributionProgram &program);
    
     std::string str() const;
     
@@ -202,13 +245,44 @@ public:
     double dsamplefac
     (double factor, const Ageable *obj, double now, double atleast) const;
 
+    // Lower the array after its children have been built: 'product' and 
+    // 'sum' over constant children are folded into a single value, and 
+    // lookups over constant children are turned into a flat table, so that
+    // the unconditioned sampling functions neither recurse nor call virtual 
+    // functions of the children; called by createDistribution
+    void compile();
+    
+    // True if this is a lookup whose entries all evaluate to the same
+    // constant 'value'; then the array can be replaced by a constant
+    bool isUniformLookup(double &value) const;
+    
+    bool isConstant() const { return(folded); };
+    bool isZeroInBin(Bin bin) const;
+    Purity getPurity() const;
+    
+    void emit(DistributionProgram &program);
+    bool setProgram(DistributionProgram *program);
+
     std::string str() const;
     
 private:
+friend class DistributionProgram;
+    int lookupIndex(const Ageable *obj) const;
+    
     Distribution **array;
     unsigned int len; 
     int min;
     NumberOf what;
+    
+    // see 'compile'
+    bool folded;
+    double dfolded;
+    int ifolded;
+    double *dtable;
+    int *itable;
+    // the whole tree below this array, if it is not part of the tree of
+    // another array; see DistributionProgram
+    DistributionProgram *program;
 };
 
 class DistributionHost : public Distribution {
@@ -228,11 +302,118 @@ public:
     double dsamplefac
         (double factor, const Ageable *obj, double now, double atleast) const;
     
+    Purity getPurity() const;
+    
+    void emit(DistributionProgram &program);
+    bool setProgram(DistributionProgram *program);
+    
     std::string str() const;
     
 private:
     Distribution *dist;
     const CreatorCollection *hostcollection;
+    // see DistributionArray::program
+    DistributionProgram *program;
+};
+
+/*****************************************************************************
+A tree of DistributionArray and DistributionHost nodes lowered into a flat
+sequence of instructions for a small stack machine; createDistribution builds
+one for each tree (see compileDistribution). Evaluating it needs neither
+recursion nor virtual calls for the inner nodes: only getNumber() of the object
+for lookups and the sampling functions of the non-constant leaves are called.
+The instructions are emitted in the order in which the recursive functions
+sample the leaves, so that the same random numbers are drawn. Only the
+unconditioned dsample(obj, now) and isample(obj, now) use the program; the
+conditioned ('atleast') and 'fac' sampling still recurse.
+******************************************************************************/
+
+class DistributionProgram
+{
+public:
+    DistributionProgram();
+    
+    // Building, used by Distribution::emit(); each of the 'push' functions 
+    // puts one value on the stack
+    void pushConstant(double dvalue, int ivalue);
+    // 'plain' if the leaf does not condition on the object or the time
+    void pushLeaf(const Distribution *leaf, bool plain);
+    // Unconditioned exponential and uniform leaves are sampled in place; 
+    // these give the same numbers as DistributionExponential::dsample() and
+    // DistributionUniform::dsample()
+    void pushExponential(const Distribution *leaf, double rate, double shift,
+        double cutat);
+    void pushUniform(const Distribution *leaf, double min, double max);
+    // A lookup in the flat table of a compiled array
+    void pushTable(const DistributionArray *array);
+    // Replaces the last 'count' values by their product or sum
+    void pushProduct(unsigned int count);
+    void pushSum(unsigned int count);
+    // A lookup over the branches of 'array': call beginBranch() before and
+    // endBranch() after emitting the entry 'index' for every index used, and
+    // endLookup() at the end; the lookup gives the value of the chosen branch
+    unsigned int beginLookup(const DistributionArray *array);
+    void beginBranch(unsigned int lookup, unsigned int index);
+    void endBranch(unsigned int lookup);
+    void endLookup(unsigned int lookup);
+    // The values between these two are sampled for the host of the object
+    void beginHost(const Distribution *host);
+    void endHost();
+    
+    // False if the program is incomplete or nests deeper than the evaluation
+    // supports, then the tree has to be evaluated recursively
+    bool isValid() const;
+    unsigned int size() const { return(code.size()); };
+    
+    double dsample(const Ageable *obj, double now) const;
+    int isample(const Ageable *obj, double now) const;
+    
+private:
+    // the maximal number of values on the stack and of nested hosts
+    enum { MAXDEPTH = 32 };
+    
+    enum OpCode { 
+        OpConstant, OpLeaf, OpLeafPlain, OpExponential, OpUniform, OpTable, 
+        OpProduct, OpSum, OpLookup, OpJump, OpHost, OpHostEnd
+    };
+    struct Instruction {
+        OpCode op;
+        // the instruction to continue with; the last ones of the branches of
+        // a lookup continue after it. While the lookup is built, the ones
+        // still to be set by endLookup() are chained through here
+        unsigned int next;
+        // OpLeaf, OpLeafPlain, OpExponential, OpUniform: the leaf; OpHost: 
+        // the host node (for errors)
+        const Distribution *dist;
+        // OpTable, OpLookup
+        const DistributionArray *array;
+        // OpConstant: the values; OpExponential: the rate, shift and cut
+        // point; OpUniform: the range
+        double dvalue, lower, upper;
+        int ivalue;
+        // OpExponential, OpUniform
+        unsigned int randcore;
+        // OpProduct, OpSum: the number of values; OpLookup: while it is built,
+        // the first of the instructions to be chained (see 'next')
+        unsigned int count;
+        // OpLookup: the position of the branches in 'targets'
+        unsigned int target;
+        // OpLookup: the number of values on the stack before it
+        int depth;
+    };
+    
+    Instruction &append(OpCode op);
+    void push();
+    template<bool integer> 
+    double run(const Ageable *obj, double now) const;
+    
+    std::vector<Instruction> code;
+    std::vector<unsigned int> targets;
+    int depth, maxdepth;
+    int hosts, maxhosts;
+    // the size of 'code' when the last lookup ended; a branch that ends with
+    // a lookup needs an OpJump, as its end is not a single instruction
+    unsigned int lookupend;
 };
 
 class DistributionDiscrete : public Distribution {
@@ -277,6 +458,8 @@ public:
     
     double dsample() const;
     double dsample(double atleast) const;
+    
+    Purity getPurity() const;
 
     std::string str() const;
 
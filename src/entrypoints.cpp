@@ -18,6 +18,10 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+
 #include "distribution.h"
 #include "event.h"
 
@@ -26,7 +30,9 @@
 #include "infection.h"
 
 #include "population.h"
+#include "spill.h"
 #include "scheduler.h"
+#include "rangen.h"
 
 #include "initdel.h"
 
@@ -34,6 +40,131 @@ using namespace std;
 
 extern Distribution **typesinitran;
 
+// Helpers for rif_getMemory(): the heap memory used by the lists of a Person; a
+// SmallVector only uses the heap once it outgrows its inline storage
+template <class T, unsigned int N>
+double heapBytes(const SmallVector<T,N> *l)
+{
+    return(l->isAllocated() ? (double)l->capacity()*sizeof(T) : 0.0);
+}
+
+template <class T>
+double heapBytes(const std::vector<T> *l)
+{
+    return((double)l->capacity()*sizeof(T));
+}
+
+// Helpers for rif_getNotifications() and rif_getGPVisits(): the rows of a log
+// whose person (given by the column 'puid') is active, or dead if 'oldpeople';
+// returns false if these are all rows, so that the columns can be copied as
+// they are
+bool selectRows(const vector<int> &puid, bool oldpeople, vector<int> &rows)
+{
+    Population::PersonState state = oldpeople ? 
+        Population::PersonDead : Population::PersonActive;
+    for (unsigned int i = 0; i < puid.size(); i++) {
+        if (global::population->getPersonState(puid[i]) == state) {
+            rows.push_back(i);
+        }
+    }
+    return(rows.size() < puid.size());
+}
+
+// ... and the selected rows of a column as a new R vector, which is not
+// protected yet
+ROBJ copyColumn(const vector<int> &col, bool select, const vector<int> &rows)
+{
+    int n = select ? rows.size() : col.size();
+    ROBJ ans = allocVector(INTSXP, n);
+    if (!select) {
+        if (n) memcpy(INTEGER(ans), &col[0], n*sizeof(int));
+    } else {
+        for (int i = 0; i < n; i++) INTEGER(ans)[i] = col[rows[i]];
+    }
+    return(ans);
+}
+
+ROBJ copyColumn(const vector<double> &col, bool select, const vector<int> &rows)
+{
+    int n = select ? rows.size() : col.size();
+    ROBJ ans = allocVector(REALSXP, n);
+    if (!select) {
+        if (n) memcpy(REAL(ans), &col[0], n*sizeof(double));
+    } else {
+        for (int i = 0; i < n; i++) REAL(ans)[i] = col[rows[i]];
+    }
+    return(ans);
+}
+
+// The average size of the objects of an allocator
+double objectBytes(const SlabAllocator &a)
+{
+    return(a.getObjectsInUse() > 0 ? 
+        (double)a.getBytesInUse()/a.getObjectsInUse() : 0.0);
+}
+
+// Helper for rif_getTransmissionTrees(): writes the trees of the transmission
+// log in Newick format, one for each infection without parent; the nodes are
+// labelled by infuid, the branch lengths are the times between the infections
+// of parent and child. The trees can be deep, so no recursion is used.
+vector<string> newickForest(const vector<TransmissionRecord> &log)
+{
+    unsigned int n = log.size();
+    const unsigned int none = n;
+    const unsigned int notstarted = n+1;
+    
+    // the log is ordered by infuid, so the parents can be found by bisection
+    vector<Counter> infuids(n);
+    for (unsigned int i = 0; i < n; i++) infuids[i] = log[i].infuid;
+    
+    // the children of each infection as a linked list, ordered by infuid
+    vector<unsigned int> parent(n, none), first(n, none), next(n, none);
+    for (unsigned int i = n; i-- > 0; ) {
+        if (!log[i].parentinfuid) continue;
+        vector<Counter>::iterator it = lower_bound(infuids.begin(), 
+            infuids.end(), log[i].parentinfuid);
+        if (it == infuids.end() || *it != log[i].parentinfuid) continue;
+        parent[i] = it - infuids.begin();
+        next[i] = first[parent[i]];
+        first[parent[i]] = i;
+    }
+    
+    vector<string> trees;
+    vector<unsigned int> current(n, notstarted);
+    vector<unsigned int> stack;
+    for (unsigned int root = 0; root < n; root++) {
+        if (parent[root] != none) continue;
+        ostringstream s;
+        s.precision(10);
+        stack.push_back(root);
+        while (!stack.empty()) {
+            unsigned int i = stack.back();
+            // go to the next child, if any
+            unsigned int c;
+            if (current[i] == notstarted) {
+                c = first[i];
+                if (c != none) s << "(";
+            } else {
+                c = next[current[i]];
+                if (c != none) s << ",";
+            }
+            if (c != none) {
+                current[i] = c;
+                stack.push_back(c);
+                continue;
+            }
+            // all children are written, so the node itself follows
+            if (first[i] != none) s << ")";
+            s << log[i].infuid;
+            if (i != root) s << ":" << log[i].time - log[parent[i]].time;
+            stack.pop_back();
+        }
+        s << ";";
+        trees.push_back(s.str());
+    }
+    return(trees);
+}
+
 extern "C" {
 
 ROBJ rif_omp(SEXP num)
@@ -84,9 +215,11 @@ ROBJ rif_intToChar(ROBJ vec)
 
 ROBJ rif_getStatistics()
 {
+    global::population->internalCountContacts();
+    
     ROBJ num;
     
-    PROTECT(num = allocVector(REALSXP, 21));
+    PROTECT(num = allocVector(REALSXP, 22));
     
     int i = 0;
     REAL(num)[i++] = global::abstime;
@@ -110,6 +243,7 @@ ROBJ rif_getStatistics()
     REAL(num)[i++] = (double)global::statstreatments;
     REAL(num)[i++] = (double)global::statstreatmentsvain;
     REAL(num)[i++] = (double)global::statsfollowupvisits;
+    REAL(num)[i++] = (double)global::statstransmissionsskipped;
     
     UNPROTECT(1);
     return(num);
@@ -193,6 +327,27 @@ ROBJ rif_getSeed()
     return(seed);
 }
 
+ROBJ rif_getRandomState()
+{
+    ROBJ state;
+    PROTECT(state = allocVector(INTSXP, ran::getStateSize()));
+    ran::getState((unsigned int*)INTEGER(state));
+    UNPROTECT(1);
+    return(state);
+}
+
+ROBJ rif_setRandomState(ROBJ _state)
+{
+    if (!isInteger(_state) || (unsigned int)LENGTH(_state) != 
+            ran::getStateSize()) {
+        error("not a valid random number generator state");
+    }
+    if (!ran::setState((const unsigned int*)INTEGER(_state))) {
+        error("random number generator state is not compatible");
+    }
+    return(R_NilValue);
+}
+
 ROBJ rif_getAgeRange()
 {
     ROBJ ans;
@@ -231,19 +386,21 @@ ROBJ rif_testDistribution(ROBJ _n, ROBJ _atleast)
     return(ans);
 }
 
+// The stores keep the people oldest first, but the exports list them newest
+// first, so the living people are numbered from the back
 void enumPeople()
 {
-    const PeopleList * people = global::population->getActivePeopleList();
+    const PeopleStore * people = global::population->getActivePeopleList();
     
-    int pos = 0;
-    for (PeopleList::const_iterator it = people->begin();
+    int pos = people->size();
+    for (PeopleStore::const_iterator it = people->begin();
                             it != people->end(); it++) {
         // PopID *popid = (*it)->getPopID_p();
-        (*it)->popid.adhoc = ++pos;
+        (*it)->popid.adhoc = pos--;
     }
     
     people = global::population->getDeadPeopleList();
-    for (PeopleList::const_iterator it = people->begin();
+    for (PeopleStore::const_iterator it = people->begin();
                             it != people->end(); it++) {
         (*it)->popid.adhoc = INTNA;
     }
@@ -252,10 +409,11 @@ void enumPeople()
 ROBJ rif_getPeople(ROBJ _old)
 {
     enumPeople();
+    global::population->internalCountContacts();
     
     int old = rif_asInteger(_old,0);
    
-    const PeopleList * people;
+    const PeopleStore * people;
      
     if (old) {
         people = global::population->getDeadPeopleList();
@@ -263,7 +421,32 @@ ROBJ rif_getPeople(ROBJ _old)
         people = global::population->getActivePeopleList();
     }
     
-    int popsize = people->size();
+    // the rows are collected oldest first and reversed at the end, so that
+    // the newest person comes first; the people moved to the spill file died
+    // earliest, so they end up last
+    std::vector<PersonRecord> rows;
+    std::vector<int> adhocs;
+    const SpillFile *spill = global::population->getSpillFile();
+    if (old && spill) {
+        spill->readPeople(rows);
+        adhocs.resize(rows.size(), INTNA);
+    }
+    
+    int pos = 0;
+    
+    for (PeopleStore::const_iterator it = people->begin();
+                            it != people->end(); it++) {
+        PopID popid = (*it)->getPopID();
+        if (!old && popid.adhoc != (int)people->size()-pos) 
+            error("living people are not enumerated");
+        rows.push_back(makePersonRecord(*it));
+        adhocs.push_back(popid.adhoc);
+        pos++;
+    }
+    reverse(rows.begin(), rows.end());
+    reverse(adhocs.begin(), adhocs.end());
+    
+    int popsize = rows.size();
     
     ROBJ ans;
     PROTECT(ans = allocVector(VECSXP,21));
@@ -295,63 +478,33 @@ ROBJ rif_getPeople(ROBJ _old)
     PROTECT(gpvisits = allocVector(INTSXP, popsize));
     PROTECT(notifications = allocVector(INTSXP, popsize));
     
-    int pos = 0;
-    
-    for (PeopleList::const_iterator it = people->begin();
-                            it != people->end(); it++) {
-        PopID popid = (*it)->getPopID();
-        if (!old && popid.adhoc != pos+1) 
-            error("living people are not enumerated");
-            
-        INTEGER(puid)[pos] = (*it)->puid;
-        int adhoc = popid.adhoc;
-        if (adhoc != INTNA) {
-            INTEGER(adhocid)[pos] = adhoc;
+    for (pos = 0; pos < popsize; pos++) {
+        const PersonRecord &r = rows[pos];
+        INTEGER(puid)[pos] = r.puid;
+        if (adhocs[pos] != INTNA) {
+            INTEGER(adhocid)[pos] = adhocs[pos];
         } else {
             INTEGER(adhocid)[pos] = R_NaInt;
         }
-        INTEGER(type)[pos] = (*it)->getType();
-        INTEGER(bin)[pos] = (*it)->getBinLinearised();
-        REAL(timebirth)[pos] = (*it)->getTimeBirth();
-        REAL(timedeath)[pos] = (*it)->getTimeDeath();
-        INTEGER(curnumpartners)[pos] =
-(*it)->getNumber(NumberOfPartnersCurrent);
-        INTEGER(totnumpartners)[pos] = (*it)->getNumber(NumberOfPartnersTotal);
-        INTEGER(oneypartners)[pos] = (*it)->getNumber(NumberOfPartnersWithin);
-        INTEGER(contacts)[pos] = (*it)->getNumber(NumberOfContacts);
-        INTEGER(contactsunprot)[pos] =
-(*it)->getNumber(NumberOfContactsUnprotected);
-        INTEGER(infectionscur)[pos] =
-(*it)->getNumber(NumberOfInfectionsCurrent);
-        INTEGER(infectionstot)[pos] = (*it)->getNumber(NumberOfInfectionsTotal);
-        INTEGER(infectionswithin)[pos] =
-(*it)->getNumber(NumberOfInfectionsWithin);
-        
-        if ((*it)->idsubclass == CLASSPERSONFEMALE) {
-            INTEGER(pregnant)[pos] = ((PersonFemale*)(*it))->isPregnant();
-            INTEGER(children)[pos] =
-((PersonFemale*)(*it))->getNumber(NumberOfChildren);
-            INTEGER(abortions)[pos] =
-((PersonFemale*)(*it))->getNumber(NumberOfAbortions);
-            INTEGER(pregnancies)[pos] =
-((PersonFemale*)(*it))->getNumber(NumberOfPregnancies);
-        } else if ((*it)->idsubclass == CLASSPERSONMALE) {
-            INTEGER(pregnant)[pos] = R_NaInt;
-            INTEGER(children)[pos] =
-((PersonMale*)(*it))->getNumber(NumberOfChildren);;
-            INTEGER(abortions)[pos] = R_NaInt;
-            INTEGER(pregnancies)[pos] = R_NaInt;
-        } else {
-            INTEGER(pregnant)[pos] = R_NaInt;
-            INTEGER(children)[pos] = R_NaInt;
-            INTEGER(abortions)[pos] = R_NaInt;
-            INTEGER(pregnancies)[pos] = R_NaInt;
-        }
-
-        INTEGER(treatments)[pos] = (*it)->getNumber(NumberOfTreatments);
-        INTEGER(gpvisits)[pos] = (*it)->getNumber(NumberOfGPVisits);
-        INTEGER(notifications)[pos] = (*it)->getNumber(NumberOfNotifications);
-        pos++;
+        INTEGER(type)[pos] = r.type;
+        INTEGER(bin)[pos] = r.bin;
+        REAL(timebirth)[pos] = r.timebirth;
+        REAL(timedeath)[pos] = r.timedeath;
+        INTEGER(curnumpartners)[pos] = r.curnumpartners;
+        INTEGER(totnumpartners)[pos] = r.totnumpartners;
+        INTEGER(oneypartners)[pos] = r.oneypartners;
+        INTEGER(contacts)[pos] = r.contacts;
+        INTEGER(contactsunprot)[pos] = r.contactsunprot;
+        INTEGER(infectionscur)[pos] = r.infectionscur;
+        INTEGER(infectionstot)[pos] = r.infectionstot;
+        INTEGER(infectionswithin)[pos] = r.infectionswithin;
+        INTEGER(pregnant)[pos] = r.pregnant;
+        INTEGER(children)[pos] = r.children;
+        INTEGER(abortions)[pos] = r.abortions;
+        INTEGER(pregnancies)[pos] = r.pregnancies;
+        INTEGER(treatments)[pos] = r.treatments;
+        INTEGER(gpvisits)[pos] = r.gpvisits;
+        INTEGER(notifications)[pos] = r.notifications;
     }
     
     ROBJ typelabels;
@@ -407,10 +560,11 @@ mkChar(global::persontypes->getCreator(type)->getBinName(bin).c_str()));
 ROBJ rif_getPartnerships(ROBJ _old)
 {
     enumPeople();
+    global::population->internalCountContacts();
     
     int old = rif_asInteger(_old,0);
    
-    const PartnershipList *psl;
+    const PartnershipStore *psl;
      
     if (old) {
         psl = global::population->getEndedPartnershipList();
@@ -442,8 +596,10 @@ ROBJ rif_getPartnerships(ROBJ _old)
     PROTECT(contacts = allocVector(INTSXP, size));
     PROTECT(contactsunprot = allocVector(INTSXP, size));
     
-    int pos = 0;
-    for (PartnershipList::const_iterator it = psl->begin();
+    // the store is oldest first, so fill the rows from the back to list the
+    // newest partnership first
+    int pos = size - 1;
+    for (PartnershipStore::const_iterator it = psl->begin();
             it != psl->end(); it++) {
         INTEGER(psuid)[pos] = (*it)->psuid;
         int adhocid = (*it)->getPerson1()->getPopID().adhoc;
@@ -472,7 +628,7 @@ ROBJ rif_getPartnerships(ROBJ _old)
         INTEGER(contacts)[pos] = (*it)->getNumber(NumberOfContacts);
         INTEGER(contactsunprot)[pos] =
 (*it)->getNumber(NumberOfContactsUnprotected);
-        pos++;
+        pos--;
     }
     
     ROBJ formertypelabels;
@@ -529,7 +685,7 @@ ROBJ rif_getInfections(ROBJ _oldinfections, ROBJ _oldpeople)
     int oldinfections = rif_asInteger(_oldinfections,0);
     int oldpeople = rif_asInteger(_oldpeople,0);
    
-    const PeopleList * people;
+    const PeopleStore * people;
      
     if (oldpeople) {
         people = global::population->getDeadPeopleList();
@@ -537,18 +693,59 @@ ROBJ rif_getInfections(ROBJ _oldinfections, ROBJ _oldpeople)
         people = global::population->getActivePeopleList();
     }
     
-    int pos = 0;
-    for (PeopleList::const_iterator it = people->begin();
+    // the rows are collected oldest first and reversed at the end, so that
+    // the newest host and, per host, the newest infection come first; the
+    // infections of the people in the spill file end up last
+    std::vector<InfectionRecord> rows;
+    std::vector<int> adhocs;
+    const SpillFile *spill = global::population->getSpillFile();
+    if (oldpeople && spill) {
+        spill->readInfections(rows, oldinfections);
+        adhocs.resize(rows.size(), INTNA);
+        // the current infections are written newest first per host
+        if (!oldinfections) {
+            std::vector<InfectionRecord>::iterator first = rows.begin();
+            while (first != rows.end()) {
+                std::vector<InfectionRecord>::iterator last = first;
+                while (last != rows.end() && last->hostpuid == first->hostpuid)
+                    last++;
+                reverse(first, last);
+                first = last;
+            }
+        }
+    }
+    
+    for (PeopleStore::const_iterator it = people->begin();
             it != people->end(); it++) {
+        
         const InfectionList * infections;
         if (oldinfections) {
             infections = ((*it)->getInfectionsOld());
         } else {
             infections = (*it)->getInfections();
         }
-        pos += infections->size();
+        
+        int adhocid = (*it)->getPopID().adhoc;
+        
+        // the current infections are newest first, the old ones oldest first
+        if (oldinfections) {
+            for (InfectionList::const_iterator itinf = infections->begin();
+                itinf != infections->end(); itinf++) {
+                rows.push_back(makeInfectionRecord(*itinf, *it));
+                adhocs.push_back(adhocid);
+            }
+        } else {
+            for (InfectionList::const_reverse_iterator itinf =
+                infections->rbegin(); itinf != infections->rend(); itinf++) {
+                rows.push_back(makeInfectionRecord(*itinf, *it));
+                adhocs.push_back(adhocid);
+            }
+        }
     }
+    reverse(rows.begin(), rows.end());
+    reverse(adhocs.begin(), adhocs.end());
     
+    int num = rows.size();
     
     ROBJ ans;
     PROTECT(ans = allocVector(VECSXP,11));
@@ -556,67 +753,43 @@ ROBJ rif_getInfections(ROBJ _oldinfections, ROBJ _oldpeople)
     ROBJ infuid, strainid, parentinfuid, hostpuid, hostadhocid, type, bin,
 birth, endinfection, death, psuid;
     
-    PROTECT(infuid = allocVector(INTSXP,pos));
-    PROTECT(strainid = allocVector(INTSXP,pos));
-    PROTECT(parentinfuid = allocVector(INTSXP,pos));
-    PROTECT(hostpuid = allocVector(INTSXP,pos));
-    PROTECT(hostadhocid = allocVector(INTSXP,pos));
-    PROTECT(type = allocVector(INTSXP,pos));
-    PROTECT(bin = allocVector(INTSXP,pos));
-    PROTECT(birth = allocVector(REALSXP,pos));
-    PROTECT(endinfection = allocVector(REALSXP,pos));
-    PROTECT(death = allocVector(REALSXP,pos));
-    PROTECT(psuid = allocVector(INTSXP,pos));
-    
-    pos = 0;
-    for (PeopleList::const_iterator it = people->begin();
-            it != people->end(); it++) {
-        
-        const InfectionList * infections;
-        if (oldinfections) {
-            infections = ((*it)->getInfectionsOld());
+    PROTECT(infuid = allocVector(INTSXP,num));
+    PROTECT(strainid = allocVector(INTSXP,num));
+    PROTECT(parentinfuid = allocVector(INTSXP,num));
+    PROTECT(hostpuid = allocVector(INTSXP,num));
+    PROTECT(hostadhocid = allocVector(INTSXP,num));
+    PROTECT(type = allocVector(INTSXP,num));
+    PROTECT(bin = allocVector(INTSXP,num));
+    PROTECT(birth = allocVector(REALSXP,num));
+    PROTECT(endinfection = allocVector(REALSXP,num));
+    PROTECT(death = allocVector(REALSXP,num));
+    PROTECT(psuid = allocVector(INTSXP,num));
+    
+    int pos;
+    for (pos = 0; pos < num; pos++) {
+        const InfectionRecord &r = rows[pos];
+        INTEGER(infuid)[pos] = r.infuid;
+        INTEGER(strainid)[pos] = r.strainid;
+        if (r.parentinfuid) {
+            INTEGER(parentinfuid)[pos] = r.parentinfuid;
         } else {
-            infections = (*it)->getInfections();
+            INTEGER(parentinfuid)[pos] = R_NaInt;
         }
-        
-        int adhocid = (*it)->getPopID().adhoc;
-                
-        for (InfectionList::const_iterator itinf = infections->begin();
-            itinf != infections->end(); itinf++) {
-            INTEGER(infuid)[pos] = (*itinf)->infuid;
-            INTEGER(strainid)[pos] = (*itinf)->getStrainID();
-            const Infection *parent = (*itinf)->getParent();
-            if (parent) {
-                INTEGER(parentinfuid)[pos] = parent->infuid;
-            } else {
-                INTEGER(parentinfuid)[pos] = R_NaInt;
-            }
-            INTEGER(hostpuid)[pos] = (*it)->puid;
-            if (adhocid != INTNA) {
-                INTEGER(hostadhocid)[pos] = adhocid;
-            } else {
-                INTEGER(hostadhocid)[pos] = R_NaInt;
-            }
-            
-            INTEGER(type)[pos] = (*itinf)->getType();
-            INTEGER(bin)[pos] = (*itinf)->getBinLinearised();
-            REAL(birth)[pos] = (*itinf)->getTimeBirth();
-            if ((*itinf)->getTimeOfImmunity() < (*it)->getTimeDeath()) {
-                REAL(endinfection)[pos] = (*itinf)->getTimeOfImmunity();
-            } else {
-                REAL(endinfection)[pos] = R_NaReal;
-            }
-            if ((*itinf)->getTimeDeath() < (*it)->getTimeDeath()) {
-                REAL(death)[pos] = (*itinf)->getTimeDeath();
-            } else {
-                REAL(death)[pos] = R_NaReal;
-            }
-            if ((*itinf)->getPartnership()) {
-                INTEGER(psuid)[pos] = (*itinf)->getPartnership()->psuid;
-            } else {
-                INTEGER(psuid)[pos] = R_NaInt;
-            }
-            pos++;        
+        INTEGER(hostpuid)[pos] = r.hostpuid;
+        if (adhocs[pos] != INTNA) {
+            INTEGER(hostadhocid)[pos] = adhocs[pos];
+        } else {
+            INTEGER(hostadhocid)[pos] = R_NaInt;
+        }
+        INTEGER(type)[pos] = r.type;
+        INTEGER(bin)[pos] = r.bin;
+        REAL(birth)[pos] = r.birth;
+        REAL(endinfection)[pos] = r.endinfection;
+        REAL(death)[pos] = r.death;
+        if (r.psuid) {
+            INTEGER(psuid)[pos] = r.psuid;
+        } else {
+            INTEGER(psuid)[pos] = R_NaInt;
         }
     }
     
@@ -663,24 +836,13 @@ mkChar(global::infectiontypes->getCreator(type)->getBinName(bin).c_str()));
 
 ROBJ rif_getNotifications(ROBJ _oldpeople)
 {
-    enumPeople();
-    
     int oldpeople = rif_asInteger(_oldpeople,0);
-   
-    const PeopleList * people;
-     
-    if (oldpeople) {
-        people = global::population->getDeadPeopleList();
-    } else {
-        people = global::population->getActivePeopleList();
-    }
-    
-    int pos = 0;
-    for (PeopleList::const_iterator it = people->begin();
-            it != people->end(); it++) {
-        pos += (*it)->getSingleNotifications()->size();
-    }
     
+    // the notifications sent by the active or dead people; those of the
+    // people in the spill file are still in the log
+    const NotificationLog *log = global::population->getNotificationLog();
+    vector<int> rows;
+    bool select = selectRows(log->puid1, oldpeople, rows);
     
     ROBJ ans;
     PROTECT(ans = allocVector(VECSXP,13));
@@ -690,48 +852,19 @@ ROBJ rif_getNotifications(ROBJ _oldpeople)
         puid2, ptype2, pbin2,
         psuid, pstype, psbin;
 
-    PROTECT(ntype = allocVector(INTSXP,pos));
-    PROTECT(nid = allocVector(INTSXP,pos));
-    PROTECT(linknumber = allocVector(INTSXP,pos));
-    PROTECT(time = allocVector(REALSXP,pos));
-    PROTECT(puid1 = allocVector(INTSXP,pos));
-    PROTECT(ptype1 = allocVector(INTSXP,pos));
-    PROTECT(pbin1 = allocVector(INTSXP,pos));
-    PROTECT(puid2 = allocVector(INTSXP,pos));
-    PROTECT(ptype2 = allocVector(INTSXP,pos));
-    PROTECT(pbin2 = allocVector(INTSXP,pos));
-    PROTECT(psuid = allocVector(INTSXP,pos));
-    PROTECT(pstype = allocVector(INTSXP,pos));
-    PROTECT(psbin = allocVector(INTSXP,pos));
-
-    pos = 0;
-    for (PeopleList::const_iterator it = people->begin();
-            it != people->end(); it++) {
-        
-        const SingleNotificationList *snl = (*it)->getSingleNotifications();
-        
-        // int adhocid = (*it)->getPopID().adhoc;
-                
-        for (SingleNotificationList::const_iterator itsn = snl->begin();
-                itsn != snl->end(); itsn++) {
-
-            INTEGER(ntype)[pos] = (*itsn).ntype;
-            INTEGER(nid)[pos] = (*itsn).nid;
-            INTEGER(linknumber)[pos] = (*itsn).linknumber;            
-            REAL(time)[pos] = (*itsn).time;
-            INTEGER(puid1)[pos] = (*itsn).puid1;
-            INTEGER(puid2)[pos] = (*itsn).puid2;
-            INTEGER(ptype1)[pos] = (*itsn).ptype1;
-            INTEGER(ptype2)[pos] = (*itsn).ptype2;
-            INTEGER(pbin1)[pos] = (*itsn).pbin1;
-            INTEGER(pbin2)[pos] = (*itsn).pbin2;
-            INTEGER(psuid)[pos] = (*itsn).psuid;
-            INTEGER(pstype)[pos] = (*itsn).pstype;
-            INTEGER(psbin)[pos] = (*itsn).psbin;
-
-            pos++;        
-        }
-    }
+    PROTECT(ntype = copyColumn(log->ntype, select, rows));
+    PROTECT(nid = copyColumn(log->nid, select, rows));
+    PROTECT(linknumber = copyColumn(log->linknumber, select, rows));
+    PROTECT(time = copyColumn(log->time, select, rows));
+    PROTECT(puid1 = copyColumn(log->puid1, select, rows));
+    PROTECT(ptype1 = copyColumn(log->ptype1, select, rows));
+    PROTECT(pbin1 = copyColumn(log->pbin1, select, rows));
+    PROTECT(puid2 = copyColumn(log->puid2, select, rows));
+    PROTECT(ptype2 = copyColumn(log->ptype2, select, rows));
+    PROTECT(pbin2 = copyColumn(log->pbin2, select, rows));
+    PROTECT(psuid = copyColumn(log->psuid, select, rows));
+    PROTECT(pstype = copyColumn(log->pstype, select, rows));
+    PROTECT(psbin = copyColumn(log->psbin, select, rows));
 
     ROBJ ntypelabels;
     PROTECT(ntypelabels = allocVector(STRSXP,global::notifiertypesnum));
@@ -784,7 +917,7 @@ ROBJ rif_getNotifications(ROBJ _oldpeople)
     setAttrib(psbin, install("levels"), psbinlabels);
 
     
-    pos = 0;
+    int pos = 0;
     SET_VECTOR_ELT(ans,pos++, ntype);
     SET_VECTOR_ELT(ans,pos++, nid);
     SET_VECTOR_ELT(ans,pos++, linknumber);
@@ -822,24 +955,13 @@ ROBJ rif_getNotifications(ROBJ _oldpeople)
 
 ROBJ rif_getGPVisits(ROBJ _oldpeople)
 {
-    enumPeople();
-    
     int oldpeople = rif_asInteger(_oldpeople,0);
-   
-    const PeopleList * people;
-     
-    if (oldpeople) {
-        people = global::population->getDeadPeopleList();
-    } else {
-        people = global::population->getActivePeopleList();
-    }
-    
-    int pos = 0;
-    for (PeopleList::const_iterator it = people->begin();
-            it != people->end(); it++) {
-        pos += (*it)->getSingleGPVisits()->size();
-    }
     
+    // the GP visits of the active or dead people; those of the people in the
+    // spill file are still in the log
+    const GPVisitLog *log = global::population->getGPVisitLog();
+    vector<int> rows;
+    bool select = selectRows(log->puid, oldpeople, rows);
     
     ROBJ ans;
     PROTECT(ans = allocVector(VECSXP,12));
@@ -848,45 +970,18 @@ ROBJ rif_getGPVisits(ROBJ _oldpeople)
          dirtreated, tested, posresults,
          puid, ptype, pbin;
     
-    PROTECT(gptype = allocVector(INTSXP,pos));
-    PROTECT(nid = allocVector(INTSXP,pos));
-    PROTECT(linknumber = allocVector(INTSXP,pos));
-    PROTECT(time = allocVector(REALSXP,pos));
-    PROTECT(ntype = allocVector(INTSXP,pos));
-    PROTECT(cause = allocVector(INTSXP,pos));
-    PROTECT(dirtreated = allocVector(INTSXP,pos));
-    PROTECT(tested = allocVector(INTSXP,pos));
-    PROTECT(posresults = allocVector(INTSXP,pos));
-    PROTECT(puid = allocVector(INTSXP,pos));
-    PROTECT(ptype = allocVector(INTSXP,pos));
-    PROTECT(pbin = allocVector(INTSXP,pos));
-
-    pos = 0;
-    
-    for (PeopleList::const_iterator it = people->begin();
-            it != people->end(); it++) {
-        
-        const SingleGPVisitList *gpvl = (*it)->getSingleGPVisits();
-        
-        for (SingleGPVisitList::const_iterator itgpv = gpvl->begin();
-                itgpv != gpvl->end(); itgpv++) {
-
-            INTEGER(gptype)[pos] = (*itgpv).gptype;
-            INTEGER(nid)[pos] = (*itgpv).nid;
-            INTEGER(linknumber)[pos] = (*itgpv).linknumber;            
-            REAL(time)[pos] = (*itgpv).time;
-            INTEGER(ntype)[pos] = (*itgpv).ntype;
-            INTEGER(cause)[pos] = (*itgpv).cause;
-            INTEGER(dirtreated)[pos] = (*itgpv).dirtreated;
-            INTEGER(tested)[pos] = (*itgpv).tested;
-            INTEGER(posresults)[pos] = (*itgpv).posresults;
-            INTEGER(puid)[pos] = (*itgpv).puid;
-            INTEGER(ptype)[pos] = (*itgpv).ptype;
-            INTEGER(pbin)[pos] = (*itgpv).pbin;
-
-            pos++;        
-        }
-    }
+    PROTECT(gptype = copyColumn(log->gptype, select, rows));
+    PROTECT(nid = copyColumn(log->nid, select, rows));
+    PROTECT(linknumber = copyColumn(log->linknumber, select, rows));
+    PROTECT(time = copyColumn(log->time, select, rows));
+    PROTECT(ntype = copyColumn(log->ntype, select, rows));
+    PROTECT(cause = copyColumn(log->cause, select, rows));
+    PROTECT(dirtreated = copyColumn(log->dirtreated, select, rows));
+    PROTECT(tested = copyColumn(log->tested, select, rows));
+    PROTECT(posresults = copyColumn(log->posresults, select, rows));
+    PROTECT(puid = copyColumn(log->puid, select, rows));
+    PROTECT(ptype = copyColumn(log->ptype, select, rows));
+    PROTECT(pbin = copyColumn(log->pbin, select, rows));
 
     ROBJ gptypelabels;
     PROTECT(gptypelabels = allocVector(STRSXP,global::gpvisittypesnum));
@@ -929,14 +1024,15 @@ ROBJ rif_getGPVisits(ROBJ _oldpeople)
 
 
     ROBJ causelabels;
-    PROTECT(causelabels=allocVector(STRSXP,3));
+    PROTECT(causelabels=allocVector(STRSXP,4));
     SET_STRING_ELT(causelabels, 0, mkChar("general"));
     SET_STRING_ELT(causelabels, 1, mkChar("symptoms"));
     SET_STRING_ELT(causelabels, 2, mkChar("notified"));
+    SET_STRING_ELT(causelabels, 3, mkChar("screening"));
     
     setAttrib(cause, install("levels"), causelabels);
     
-    pos = 0;
+    int pos = 0;
     SET_VECTOR_ELT(ans,pos++, gptype);
     SET_VECTOR_ELT(ans,pos++, time);
     SET_VECTOR_ELT(ans,pos++, cause);
@@ -972,6 +1068,278 @@ ROBJ rif_getGPVisits(ROBJ _oldpeople)
 
 
 
+ROBJ rif_getTransmissions()
+{
+    const vector<TransmissionRecord> *log = 
+        global::population->getTransmissions();
+    int num = log->size();
+    
+    ROBJ ans;
+    PROTECT(ans = allocVector(VECSXP,7));
+    
+    ROBJ time, infuid, parentinfuid, strainid, type, puid, psuid;
+    PROTECT(time = allocVector(REALSXP,num));
+    PROTECT(infuid = allocVector(INTSXP,num));
+    PROTECT(parentinfuid = allocVector(INTSXP,num));
+    PROTECT(strainid = allocVector(INTSXP,num));
+    PROTECT(type = allocVector(INTSXP,num));
+    PROTECT(puid = allocVector(INTSXP,num));
+    PROTECT(psuid = allocVector(INTSXP,num));
+    
+    for (int pos = 0; pos < num; pos++) {
+        const TransmissionRecord &r = (*log)[pos];
+        REAL(time)[pos] = r.time;
+        INTEGER(infuid)[pos] = r.infuid;
+        INTEGER(parentinfuid)[pos] = r.parentinfuid ? r.parentinfuid : R_NaInt;
+        INTEGER(strainid)[pos] = r.strainid;
+        INTEGER(type)[pos] = r.type;
+        INTEGER(puid)[pos] = r.hostpuid;
+        INTEGER(psuid)[pos] = r.psuid ? r.psuid : R_NaInt;
+    }
+    
+    ROBJ typelabels;
+    PROTECT(typelabels = allocVector(STRSXP,global::infectiontypesnum));
+    for (int t = 0; t < global::infectiontypesnum; t++) {
+        SET_STRING_ELT(typelabels, t,
+            mkChar(global::infectiontypes->getCreatorName(t).c_str()));
+    }
+    setAttrib(type, install("levels"), typelabels);
+    
+    int pos = 0;
+    SET_VECTOR_ELT(ans,pos++, time);
+    SET_VECTOR_ELT(ans,pos++, infuid);
+    SET_VECTOR_ELT(ans,pos++, parentinfuid);
+    SET_VECTOR_ELT(ans,pos++, strainid);
+    SET_VECTOR_ELT(ans,pos++, type);
+    SET_VECTOR_ELT(ans,pos++, puid);
+    SET_VECTOR_ELT(ans,pos++, psuid);
+    
+    UNPROTECT(1+7+1);
+    return(ans);
+}
+
+ROBJ rif_getTransmissionTrees()
+{
+    vector<string> trees = newickForest(*global::population->getTransmissions());
+    
+    ROBJ ans;
+    PROTECT(ans = allocVector(STRSXP,trees.size()));
+    for (unsigned int i = 0; i < trees.size(); i++) {
+        SET_STRING_ELT(ans, i, mkChar(trees[i].c_str()));
+    }
+    UNPROTECT(1);
+    return(ans);
+}
+
+ROBJ rif_getAttributes()
+{
+    CreatorCollection *collections[6] = { 
+        global::persontypes, global::psftypes, global::psctypes, 
+        global::infectiontypes, global::gpvisittypes, global::notifiertypes 
+    };
+    
+    int number = 0;
+    for (int c = 0; c < 6; c++) {
+        if (collections[c]) number += collections[c]->getNumberOfAttributes();
+    }
+    
+    ROBJ ans;
+    PROTECT(ans = allocVector(VECSXP,5));
+    
+    ROBJ collection, name, purity, fixed, cached;
+    PROTECT(collection = allocVector(STRSXP, number));
+    PROTECT(name = allocVector(STRSXP, number));
+    PROTECT(purity = allocVector(INTSXP, number));
+    PROTECT(fixed = allocVector(LGLSXP, number));
+    PROTECT(cached = allocVector(LGLSXP, number));
+    
+    int pos = 0;
+    for (int c = 0; c < 6; c++) {
+        CreatorCollection *cc = collections[c];
+        if (!cc) continue;
+        const bool *isfixed = cc->getAttributesIsFixedArray();
+        const Purity *attrpurity = cc->getAttributesPurityArray();
+        for (Attribute a = 0; a < cc->getNumberOfAttributes(); a++) {
+            SET_STRING_ELT(collection, pos, mkChar(cc->getName().c_str()));
+            SET_STRING_ELT(name, pos, mkChar(cc->getAttributeName(a).c_str()));
+            // factor levels start at 1
+            INTEGER(purity)[pos] = attrpurity[a] + 1;
+            LOGICAL(fixed)[pos] = isfixed[a] ? TRUE : FALSE;
+            LOGICAL(cached)[pos] = 
+                (!isfixed[a] && attrpurity[a] <= PurityTypeBin) ? TRUE : FALSE;
+            pos++;
+        }
+    }
+    
+    ROBJ puritylabels;
+    PROTECT(puritylabels = allocVector(STRSXP,5));
+    
+    pos = 0;
+    SET_STRING_ELT(puritylabels, pos++, mkChar("constant"));
+    SET_STRING_ELT(puritylabels, pos++, mkChar("typebin"));
+    SET_STRING_ELT(puritylabels, pos++, mkChar("age"));
+    SET_STRING_ELT(puritylabels, pos++, mkChar("state"));
+    SET_STRING_ELT(puritylabels, pos++, mkChar("stochastic"));
+    
+    setAttrib(purity, install("levels"), puritylabels);
+    
+    SET_VECTOR_ELT(ans, 0, collection);
+    SET_VECTOR_ELT(ans, 1, name);
+    SET_VECTOR_ELT(ans, 2, purity);
+    SET_VECTOR_ELT(ans, 3, fixed);
+    SET_VECTOR_ELT(ans, 4, cached);
+    
+    UNPROTECT(7);
+    return(ans);
+}
+
+ROBJ rif_getMemory()
+{
+    enum { PEOPLEACTIVE, PEOPLEDEAD, PEOPLEGONE, PSACTIVE, PSENDED, 
+        INFCURRENT, INFOLD, PERSONLISTS, NOTIFICATIONS, GPVISITS, 
+        EVENTSACTIVE, EVENTSINACTIVE, EVENTQUEUE, ATTRIBUTES, SLABSFREE, 
+        PEOPLESPILLED, TRANSMISSIONS, ROWS };
+    const char *labels[ROWS] = {
+        "people.active", "people.dead", "people.gone", 
+        "partnerships.active", "partnerships.ended", 
+        "infections.current", "infections.old", "person.lists",
+        "notifications", "gpvisits", 
+        "events.active", "events.inactive", "eventqueue",
+        "attributes", "slabs.free", "people.spilled", "transmissions"
+    };
+    double count[ROWS], bytes[ROWS];
+    for (int i = 0; i < ROWS; i++) {
+        count[i] = 0;
+        bytes[i] = 0;
+    }
+    
+    // people, together with what they keep in their lists
+    const PeopleStore *stores[3] = {
+        global::population->getActivePeopleList(),
+        global::population->getDeadPeopleList(),
+        global::population->getGonePeopleList()
+    };
+    double personbytes = objectBytes(Person::getAllocator());
+    for (int s = 0; s < 3; s++) {
+        for (PeopleStore::const_iterator it = stores[s]->begin();
+            it != stores[s]->end(); it++) {
+            Person *p = *it;
+            count[PEOPLEACTIVE+s]++;
+            count[ATTRIBUTES] += p->getNumberOfFixedValues();
+            
+            const InfectionList *infs[2] = {
+                p->getInfections(), p->getInfectionsOld()
+            };
+            for (int i = 0; i < 2; i++) {
+                count[INFCURRENT+i] += infs[i]->size();
+                for (InfectionList::const_iterator itinf = infs[i]->begin();
+                    itinf != infs[i]->end(); itinf++) {
+                    count[ATTRIBUTES] += (*itinf)->getNumberOfFixedValues();
+                }
+            }
+            count[PERSONLISTS] += p->getPartnerships()->size() + 
+                p->getPartnershipsOld()->size() + infs[0]->size() +
+                infs[1]->size();
+            bytes[PERSONLISTS] += heapBytes(p->getPartnerships()) + 
+                heapBytes(p->getPartnershipsOld()) + heapBytes(infs[0]) +
+                heapBytes(infs[1]);
+            
+            count[NOTIFICATIONS] += p->getNotifications()->size();
+            bytes[NOTIFICATIONS] += heapBytes(p->getNotifications());
+        }
+        bytes[PEOPLEACTIVE+s] = count[PEOPLEACTIVE+s]*personbytes;
+    }
+    double infectionbytes = objectBytes(Infection::getAllocator());
+    bytes[INFCURRENT] = count[INFCURRENT]*infectionbytes;
+    bytes[INFOLD] = count[INFOLD]*infectionbytes;
+    
+    // partnerships
+    const PartnershipStore *psstores[2] = {
+        global::population->getActivePartnershipList(),
+        global::population->getEndedPartnershipList()
+    };
+    double psbytes = objectBytes(Partnership::getAllocator());
+    for (int s = 0; s < 2; s++) {
+        for (PartnershipStore::const_iterator it = psstores[s]->begin();
+            it != psstores[s]->end(); it++) {
+            count[ATTRIBUTES] += (*it)->getNumberOfFixedValues();
+        }
+        count[PSACTIVE+s] = psstores[s]->size();
+        bytes[PSACTIVE+s] = count[PSACTIVE+s]*psbytes;
+    }
+    
+    // events; their size depends on the class, so only the common part is
+    // counted
+    int *sizes = global::scheduler->getSizes();
+    count[EVENTSACTIVE] = sizes[2];
+    count[EVENTSINACTIVE] = sizes[1] - sizes[2];
+    count[EVENTQUEUE] = sizes[0];
+    bytes[EVENTSACTIVE] = count[EVENTSACTIVE]*sizeof(Event);
+    bytes[EVENTSINACTIVE] = count[EVENTSINACTIVE]*sizeof(Event);
+    bytes[EVENTQUEUE] = count[EVENTQUEUE]*sizeof(Event*);
+    delete[] sizes;
+    
+    // attributes: the values fixed at birth (counted above) and the caches
+    CreatorCollection *collections[6] = { 
+        global::persontypes, global::psftypes, global::psctypes, 
+        global::infectiontypes, global::gpvisittypes, global::notifiertypes 
+    };
+    for (int c = 0; c < 6; c++) {
+        if (collections[c]) 
+            count[ATTRIBUTES] += collections[c]->getNumberOfCachedValues();
+    }
+    bytes[ATTRIBUTES] = count[ATTRIBUTES]*sizeof(Value);
+    
+    // memory held by the allocators but not used by any object
+    const SlabAllocator *allocators[3] = {
+        &Person::getAllocator(), &Partnership::getAllocator(), 
+        &Infection::getAllocator()
+    };
+    for (int a = 0; a < 3; a++) {
+        count[SLABSFREE] += allocators[a]->getSlabs();
+        bytes[SLABSFREE] += (double)allocators[a]->getBytesReserved() - 
+            allocators[a]->getBytesInUse();
+    }
+    
+    // dead people moved to the spill file; these use disk, not memory
+    const SpillFile *spill = global::population->getSpillFile();
+    if (spill) {
+        count[PEOPLESPILLED] = spill->getNumberOfPeople();
+        bytes[PEOPLESPILLED] = spill->getBytes();
+    }
+    
+    // the logs of notifications and GP visits
+    count[NOTIFICATIONS] += global::population->getNotificationLog()->size();
+    bytes[NOTIFICATIONS] += global::population->getNotificationLog()->bytes();
+    count[GPVISITS] = global::population->getGPVisitLog()->size();
+    bytes[GPVISITS] = global::population->getGPVisitLog()->bytes();
+    
+    // the log of transmissions
+    count[TRANSMISSIONS] = global::population->getTransmissions()->size();
+    bytes[TRANSMISSIONS] = heapBytes(global::population->getTransmissions());
+    
+    ROBJ ans;
+    PROTECT(ans = allocVector(VECSXP,3));
+    
+    ROBJ what, num, size;
+    PROTECT(what = allocVector(STRSXP, ROWS));
+    PROTECT(num = allocVector(REALSXP, ROWS));
+    PROTECT(size = allocVector(REALSXP, ROWS));
+    
+    for (int i = 0; i < ROWS; i++) {
+        SET_STRING_ELT(what, i, mkChar(labels[i]));
+        REAL(num)[i] = count[i];
+        REAL(size)[i] = bytes[i];
+    }
+    
+    SET_VECTOR_ELT(ans, 0, what);
+    SET_VECTOR_ELT(ans, 1, num);
+    SET_VECTOR_ELT(ans, 2, size);
+    
+    UNPROTECT(4);
+    return(ans);
+}
+
 ROBJ rif_getSchedulerSizes()
 {
     ROBJ ans;
@@ -1030,7 +1398,7 @@ ROBJ rif_getEventQueue(ROBJ _number, ROBJ _includetext, ROBJ _activeonly)
     }
     
     ROBJ classlabels;
-    PROTECT(classlabels = allocVector(STRSXP,14));
+    PROTECT(classlabels = allocVector(STRSXP,16));
     
     pos = 0;
     SET_STRING_ELT(classlabels, pos++, mkChar("GENERIC"));
@@ -1047,6 +1415,8 @@ ROBJ rif_getEventQueue(ROBJ _number, ROBJ _includetext, ROBJ _activeonly)
     SET_STRING_ELT(classlabels, pos++, mkChar("VISITGP"));
     SET_STRING_ELT(classlabels, pos++, mkChar("TREAT"));
     SET_STRING_ELT(classlabels, pos++, mkChar("PROVOKEVISITGP"));
+    SET_STRING_ELT(classlabels, pos++, mkChar("TRANSMISSION"));
+    SET_STRING_ELT(classlabels, pos++, mkChar("SCREENING"));
 
     setAttrib(idclass, install("levels"), classlabels);
 
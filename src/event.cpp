@@ -25,6 +25,7 @@
 #include "infection.h"
 #include "scheduler.h"
 #include "population.h"
+#include "gpvisitcreator.h"
 
 using namespace std;
 
@@ -294,6 +295,10 @@ void EventAbortion::execute()
     Event::execute();
     // inform mother about abortion
     mother->slotAbortion(why);
+    // ... and the father, who is no longer referenced by this event
+    if (father) {
+        father->slotAbortion(mother);
+    }
 }
 
 string EventAbortion::str() const
@@ -450,6 +455,50 @@ string EventHaveSex::str() const
 // END IMPLEMENTATION OF CLASS EventHaveSex
 // 
 
+// 
+// BEGIN IMPLEMENTATION OF CLASS EventTransmission
+// 
+
+EventTransmission::EventTransmission(Time time, Partnership *_ps, 
+    Infection *_infection, Person *_victim)
+// call superclass constructor
+: Event(time)
+{
+    // set subclass ID
+    idsubclass = CLASSEVENTTRANSMISSION;
+    // store variables
+    ps = _ps;
+    infection = _infection;
+    victim = _victim;
+}
+
+EventTransmission::~EventTransmission()
+{
+}
+
+void EventTransmission::execute() 
+{
+    // call the superclass method
+    Event::execute();
+    // inform partnership about the transmission
+    ps->slotTransmission(infection, victim);
+}
+
+string EventTransmission::str() const
+{
+    ostringstream s;
+    s << "EventTransmission:"
+        << "psuid=" << ps->psuid
+        << ",infuid=" << infection->infuid
+        << ",victimpuid=" << victim->puid;
+    s << "|" << Event::str();
+    return(s.str());
+}
+
+// 
+// END IMPLEMENTATION OF CLASS EventTransmission
+// 
+
 
 // 
 // BEGIN IMPLEMENTATION OF CLASS EventRemoveOld
@@ -498,7 +547,20 @@ void EventRemoveOld::execute()
             );
             break;
         }
+        case RemovePeople: {
+            // tell population object to move old dead people to the file
+            global::population->internalRemoveOldPeople();
+            // install next event for the removal of people
+            global::scheduler->insert(
+                new EventRemoveOld(
+                    global::abstime+global::removepeopleolderthan, what
+                )
+            );
+            break;
+        }
     }
+    // give the memory of the removed objects back if requested
+    if (global::compactmemory) global::population->internalCompactMemory();
 }
 
 string EventRemoveOld::str() const
@@ -515,6 +577,54 @@ string EventRemoveOld::str() const
 // 
 
 
+// 
+// BEGIN IMPLEMENTATION OF CLASS EventScreening
+// 
+
+EventScreening::EventScreening(Time time, Type _gpvisittype)
+// call superclass constructor
+: Event(time)
+{
+    // set subclass ID
+    idsubclass = CLASSEVENTSCREENING;
+    // store variables
+    gpvisittype = _gpvisittype;
+}
+
+EventScreening::~EventScreening()
+{  
+    // nothing to do
+}
+
+void EventScreening::execute() 
+{
+    // call the superclass method
+    Event::execute();
+    GPVisitCreator *gc = 
+        (GPVisitCreator*)(global::gpvisittypes->getCreator(gpvisittype));
+    // screen the population
+    gc->slotScreening();
+    // install the next campaign, if any
+    Time next = gc->getNextScreening(global::abstime);
+    if (next < MAXDOUBLE) {
+        global::scheduler->insert(new EventScreening(next, gpvisittype));
+    }
+}
+
+string EventScreening::str() const
+{
+    ostringstream s;
+    s << "EventScreening:"
+        << "gpvisittype=" << gpvisittype;
+    s << "|" << Event::str();
+    return(s.str());
+}
+
+// 
+// END IMPLEMENTATION OF CLASS EventScreening
+// 
+
+
 // 
 // BEGIN IMPLEMENTATION OF CLASS EventVisitGP
 // 
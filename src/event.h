@@ -455,6 +455,48 @@ private:
     bool unprotected;
 };
 
+/** 
+ * This is the Event when an infection is transmitted in a partnership, if
+ * transmissions are sampled from the combined hazard of contact and
+ * transmission (see 'simulation.hazardtransmission' in the configuration
+ * file); the execute() method calls the Partnership::slotTransmission() method
+ */
+class EventTransmission : public Event {
+public: 
+    /**
+     * Constructor
+     * @param time (see Event::time) 
+     * @param ps a pointer to the Partnership in which the transmission will
+     * take place
+     * @param infection the Infection that is transmitted
+     * @param victim the partner that gets infected
+     */
+    EventTransmission(Time time, Partnership *ps, Infection *infection,
+        Person *victim);
+    /**
+     * Destructor
+     */
+    ~EventTransmission();
+    
+    /**
+     * (see Event class)
+     */
+    void execute();
+    /**
+     * (see Event class)
+     */
+    std::string str() const;
+    
+private:
+    /** A pointer to the Partnership in which the transmission will
+     * take place */
+    Partnership *ps;
+    /** A pointer to the Infection that is transmitted */
+    Infection *infection;
+    /** A pointer to the Person that gets infected */
+    Person *victim;
+};
+
 /**
  * This is the Event to remove old objects from the memory; the execute()
  * method calls one of the Population::internalRemoveOld[...] methods
@@ -488,6 +530,38 @@ private:
     EnumRemove what;
 };
 
+/**
+ * This is the Event of a screening campaign; the execute() method calls the
+ * GPVisitCreator::slotScreening() method of the GP visit type, which screens
+ * the whole population at once, and installs the next campaign
+ */
+class EventScreening : public Event {
+public:
+    /**
+     * Constructor
+     * @param time (see Event::time) 
+     * @param gpvisittype the type of GP visit that defines the campaign
+     */
+    EventScreening(Time time, Type gpvisittype);
+    /**
+     * Destructor
+     */
+    ~EventScreening();
+
+    /**
+     * (see Event class)
+     */
+    void execute();
+    /**
+     * (see Event class)
+     */
+    std::string str() const;
+
+private:
+    /** the type of GP visit that defines the campaign */
+    Type gpvisittype;
+};
+
 /**
  * This is the Event that a Person seeks treatment; the execute() method calls
  * the Person::slotVisitGP() method
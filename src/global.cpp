@@ -28,6 +28,7 @@
 #include "event.h"
 
 #include <time.h>
+#include <algorithm>
 
 using namespace std;
 
@@ -74,9 +75,15 @@ Counter statstests;
 Counter statstreatments;
 Counter statstreatmentsvain;
 Counter statsfollowupvisits;
+Counter statstransmissionsskipped;
 
 double removepsolderthan;
 double removeinfolderthan;
+bool compactmemory;
+double removepeopleolderthan;
+std::string spillfilename;
+bool aggregatecontacts;
+bool hazardtransmission;
 double withintimelag;
 
 Notification NOTNOTIFIED;
@@ -160,10 +167,16 @@ void globalInitVars(bool _keepquiet)
     statstreatments         = 0;
     statstreatmentsvain     = 0;
     statsfollowupvisits     = 0;
+    statstransmissionsskipped = 0;
     
     // Initialise 'removeolder' feature variables
     removepsolderthan = MAXDOUBLE;
     removeinfolderthan = MAXDOUBLE;
+    compactmemory = false;
+    removepeopleolderthan = MAXDOUBLE;
+    spillfilename = "";
+    aggregatecontacts = false;
+    hazardtransmission = false;
     withintimelag = 365.0;
 
     // Set the person type collection to 0
@@ -222,6 +235,24 @@ void globalInitVars(bool _keepquiet)
     // Init the population object 
     population = new Population(rif_lookup(cfg,"model.population"));
     
+    // load the withintime lag
+    if (rif_exists(cfg,"simulation.withintimelag")) {
+        withintimelag = rif_asDouble(cfg,0,"simulation.withintimelag");
+    }
+    
+    // whether contacts without effect are only counted
+    if (rif_exists(cfg,"simulation.aggregatecontacts")) {
+        aggregatecontacts =
+            rif_asInteger(cfg,0,"simulation.aggregatecontacts") != 0;
+    }
+    // ... and whether transmissions are sampled without the contacts; the
+    // contacts are then only counted
+    if (rif_exists(cfg,"simulation.hazardtransmission")) {
+        hazardtransmission =
+            rif_asInteger(cfg,0,"simulation.hazardtransmission") != 0;
+        if (hazardtransmission) aggregatecontacts = true;
+    }
+    
     // Init the 'removeolderthan' feature
     // ... for partnerships
     if (rif_exists(cfg,"simulation.remove.partnershipsolderthan")) {
@@ -230,11 +261,6 @@ void globalInitVars(bool _keepquiet)
     } else {
         warning("keeping all partnerships in memory");
     }
-    //  ... install the corresponding event
-    if (removepsolderthan < MAXDOUBLE) {
-        global::scheduler->insert(new EventRemoveOld(
-            abstime+removepsolderthan, RemovePartnerships));
-    }
     
     // ... and for infections
     if (rif_exists(cfg,"simulation.remove.infectionsolderthan")) {
@@ -249,9 +275,44 @@ void globalInitVars(bool _keepquiet)
             abstime+removeinfolderthan, RemoveInfections));
     }
     
-    // load the withintime lag
-    if (rif_exists(cfg,"simulation.withintimelag")) {
-        withintimelag = rif_asDouble(cfg,0,"simulation.withintimelag");
+    // ... and for dead people, which are moved to the spill file
+    if (rif_exists(cfg,"simulation.remove.peopleolderthan")) {
+        removepeopleolderthan =
+            rif_asDouble(cfg,0,"simulation.remove.peopleolderthan");
+        // the counts 'within' a time of the people in the file are not
+        // updated; fathers of unborn children are kept in memory by
+        // Population::internalRemoveOldPeople()
+        if (removepeopleolderthan < withintimelag) {
+            warning("'simulation.remove.peopleolderthan' is set to %g",
+                withintimelag);
+            removepeopleolderthan = withintimelag;
+        }
+        // people with ended partnerships in memory are not moved, so these
+        // must be removed first
+        if (removepsolderthan > removepeopleolderthan) {
+            warning(
+                "'simulation.remove.partnershipsolderthan' is set to %g",
+                removepeopleolderthan);
+            removepsolderthan = removepeopleolderthan;
+        }
+        if (rif_exists(cfg,"simulation.remove.spillfile")) {
+            spillfilename = rif_asString(cfg,0,"simulation.remove.spillfile");
+        }
+    }
+    //  ... install the corresponding events
+    if (removepeopleolderthan < MAXDOUBLE) {
+        global::scheduler->insert(new EventRemoveOld(
+            abstime+removepeopleolderthan, RemovePeople));
+    }
+    if (removepsolderthan < MAXDOUBLE) {
+        global::scheduler->insert(new EventRemoveOld(
+            abstime+removepsolderthan, RemovePartnerships));
+    }
+    
+    // ... and whether the freed memory should be compacted afterwards
+    if (rif_exists(cfg,"simulation.remove.compactmemory")) {
+        compactmemory = 
+            rif_asInteger(cfg,0,"simulation.remove.compactmemory") != 0;
     }
     
     // Load the distribution defined in the 'test' section
@@ -172,6 +172,10 @@ meantime or due to a false positive test result */
 extern Counter statstreatmentsvain;
 /** The number of notifications that led to a GP visit of the partner */
 extern Counter statsfollowupvisits;
+/** The number of times a contact did not evaluate the transmission of an
+infection because the infection was in a bin where it can not be transmitted
+(see InfectionCreator::isTransmissibleBin()) */
+extern Counter statstransmissionsskipped;
 
 /** A variable containing the Time after which partnerships should be
  * definitely removed from the memory; see
@@ -182,6 +186,26 @@ extern Time removepsolderthan;
  * 'simulation.remove.partnershipsolderthan' in the configuration file; if the
  infection is still active after this time, it will not be removed, however */
 extern Time removeinfolderthan;
+/** If true, the memory of the Person, Partnership and Infection objects is
+ * compacted after old objects have been removed; see
+ * 'simulation.remove.compactmemory' in the configuration file */
+extern bool compactmemory;
+/** A variable containing the Time after which dead people are moved from the
+ * memory to the spill file; see 'simulation.remove.peopleolderthan' in the
+ * configuration file */
+extern Time removepeopleolderthan;
+/** The name of the spill file, see 'simulation.remove.spillfile' in the
+ * configuration file; empty for a temporary file */
+extern std::string spillfilename;
+/** If true, the contacts in partnerships where they can neither transmit an
+ * infection nor lead to a pregnancy are not simulated as events but counted
+ * when needed; see 'simulation.aggregatecontacts' in the configuration file */
+extern bool aggregatecontacts;
+/** If true, the transmissions in a partnership are sampled directly from the
+ * contact rate times the transmission probability per contact, instead of
+ * testing each contact; see 'simulation.hazardtransmission' in the
+ * configuration file */
+extern bool hazardtransmission;
 /** A variable that stores the duration for the 'within' property of number of
 infections, number of partnerships */
 extern Time withintimelag;
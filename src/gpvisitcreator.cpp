@@ -22,6 +22,9 @@
 #include "infection.h"
 #include "person.h"
 #include "notifier.h"
+#include "population.h"
+#include "scheduler.h"
+#include "rangen.h"
 
 #include <iostream>
 
@@ -128,6 +131,32 @@ GPVisitCreator::GPVisitCreator(
             ->checkRange(0,global::notifiertypesnum-1);
     }
 
+    // the screening campaigns, if any
+    screeningstart = MAXDOUBLE;
+    screeninginterval = MAXDOUBLE;
+    screeningend = MAXDOUBLE;
+    probscreening = 0;
+    if (rif_exists(cfg,"screening")) {
+        screeningstart = rif_asDouble(cfg,0,"screening.start");
+        if (screeningstart < global::abstime) {
+            rif_error(rif_lookup(cfg,"screening.start"),
+                "screening must not start in the past");
+        }
+        if (rif_exists(cfg,"screening.interval")) {
+            screeninginterval = rif_asDouble(cfg,0,"screening.interval");
+            if (screeninginterval <= 0) {
+                rif_error(rif_lookup(cfg,"screening.interval"),
+                    "the interval between screenings must be positive");
+            }
+        }
+        if (rif_exists(cfg,"screening.end")) {
+            screeningend = rif_asDouble(cfg,0,"screening.end");
+        }
+        probscreening = installAttribute(global::persontypes,
+            "probability of being screened",
+            "probability", "screening", DOUBLENA);
+        global::scheduler->insert(new EventScreening(screeningstart, type));
+    }
 
 }
 
@@ -139,7 +168,21 @@ GPVisitCreator::~GPVisitCreator()
 }
 
 
-SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
+double GPVisitCreator::draw(const double *&draws) const
+{
+    return(draws ? *draws++ : uniform->dsample());
+}
+
+int GPVisitCreator::getNumberOfDraws() const
+{
+    // direct treatment, testing and obeying: one overall and one per type;
+    // the test results: one per type; the notifications: three
+    return(3*(1 + global::infectiontypesnum) + global::infectiontypesnum + 3);
+}
+
+SingleGPVisit GPVisitCreator::makeVisit(
+    Person *person, Notification notif, const double *draws
+)
 {
     double p,u;
     bool dirtreated[global::infectiontypesnum];
@@ -173,7 +216,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
     
     // Should be treated directly overall?
     p = person->getAttribute(probdirtreatall);
-    u = uniform->dsample();
+    u = draw(draws);
     if (u < p) {
         for (Type i = 0; i < global::infectiontypesnum; i++) {
             if (typeistarget[i]) {
@@ -186,7 +229,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
         for (Type i = 0; i < global::infectiontypesnum; i++) {
             if (typeistarget[i]) {
                 p = person->getAttribute(probdirtreatspec);
-                u = uniform->dsample();
+                u = draw(draws);
                 if (u < p) {
                     person->slotTreat(i);
                     dirtreated[i] = true;
@@ -197,7 +240,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
     
     // So, eventual direct treatment done, check whether should do a test
     p = person->getAttribute(probtestall);
-    u = uniform->dsample();
+    u = draw(draws);
     if (u < p) {
         for (Type i = 0; i < global::infectiontypesnum; i++) {
             if (typeistarget[i] && !dirtreated[i]) {
@@ -209,7 +252,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
         for (Type i = 0; i < global::infectiontypesnum; i++) {
             if (typeistarget[i]) {
                 p = person->getAttribute(probtestspec);
-                u = uniform->dsample();
+                u = draw(draws);
                 if (u < p) {
                     dotest[i] = true;
                 }
@@ -222,7 +265,8 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
         if (dotest[i]) {
             InfectionCreator *ic =
                 (InfectionCreator *)global::infectiontypes->getCreator(i);
-            result[i] = ic->getTestResult(person);
+            result[i] = draws ? ic->getTestResult(person, draw(draws))
+                              : ic->getTestResult(person);
             if (result[i]) {
                 person->slotTestedPositive(i);   
             }
@@ -232,7 +276,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
 
     // if person obeys, install treatment events
     p = person->getAttribute(probobeyall);
-    u = uniform->dsample();
+    u = draw(draws);
     if (u < p) {
         for (Type i = 0; i < global::infectiontypesnum; i++) {
             if (result[i]) {
@@ -243,7 +287,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
         for (Type i = 0; i < global::infectiontypesnum; i++) {
             if (result[i]) {
                 p = person->getAttribute(probobeyspec);
-                u = uniform->dsample();
+                u = draw(draws);
                 if (u < p) {
                     person->slotTreat(i,waitforresult[i]);
                 }
@@ -256,7 +300,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
     if (global::gpvisittypesnum>0) {
         person->slotNotificationStarts(notif);
         p = person->getAttribute(probnotify);
-        u = uniform->dsample();
+        u = draw(draws);
         if (u < p) {
             gpv.ntype = (int)floor(person->getAttribute(notifiertype));
             Notifier *nc = 
@@ -264,7 +308,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
             nc->notifyPartners(person, notif);
         }
         p = person->getAttribute(probnotify2);
-        u = uniform->dsample();
+        u = draw(draws);
         if (u < p) {
             gpv.ntype = (int)floor(person->getAttribute(notifiertype2));
             Notifier *nc = 
@@ -272,7 +316,7 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
             nc->notifyPartners(person, notif);
         }
         p = person->getAttribute(probnotify3);
-        u = uniform->dsample();
+        u = draw(draws);
         if (u < p) {
             gpv.ntype = (int)floor(person->getAttribute(notifiertype3));
             Notifier *nc = 
@@ -293,3 +337,53 @@ SingleGPVisit GPVisitCreator::makeVisit(Person *person, Notification notif)
    
     return(gpv);
 }
+
+void GPVisitCreator::slotScreening()
+{
+    // select the eligible people once, in the order of the population; the
+    // attributes are not thread safe and are evaluated here
+    vector<Person*> eligible;
+    vector<double> prob;
+    const PeopleStore *people = global::population->getActivePeopleList();
+    eligible.reserve(people->size());
+    prob.reserve(people->size());
+    for (PeopleStore::const_iterator it = people->begin();
+        it != people->end(); it++) {
+        double p = (*it)->getAttribute(probscreening);
+        if (p > 0) {
+            eligible.push_back(*it);
+            prob.push_back(p);
+        }
+    }
+    int n = eligible.size();
+    if (n == 0) return;
+    
+    // draw the uniforms of all eligible people in parallel; person i uses the
+    // numbers i*k to (i+1)*k-1 of a stream that is new for every campaign:
+    // the first to decide whether the person is screened, the rest for the
+    // visit itself
+    int k = 1 + getNumberOfDraws();
+    unsigned long long int key = ran::rand_dia64(uniform->getRandcore());
+    vector<double> draws((size_t)n*k);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < k; j++) {
+            draws[(size_t)i*k + j] = ran::dran(key, (unsigned long long)i*k + j);
+        }
+    }
+    
+    // apply the results one by one
+    for (int i = 0; i < n; i++) {
+        const double *d = &draws[(size_t)i*k];
+        if (d[0] < prob[i]) eligible[i]->slotScreened(getType(), d + 1);
+    }
+}
+
+Time GPVisitCreator::getNextScreening(Time time) const
+{
+    if (screeninginterval == MAXDOUBLE) return(MAXDOUBLE);
+    Time next = time + screeninginterval;
+    return(next <= screeningend ? next : MAXDOUBLE);
+}
@@ -32,10 +32,27 @@ public:
 
     std::string getBasetype() const { return("GENERIC"); };
 
+    // If 'draws' is given, the uniform numbers are taken from there instead
+    // of sampling them; at most getNumberOfDraws() of them are used
     SingleGPVisit makeVisit(
-        Person *person, Notification notif = global::NOTNOTIFIED);
+        Person *person, Notification notif = global::NOTNOTIFIED,
+        const double *draws = 0);
+    int getNumberOfDraws() const;
+
+    // Screens the eligible people of the active population in one go; the
+    // decisions are drawn in parallel, one independent stream per person, and
+    // then applied in the order of the population, so that the outcome does
+    // not depend on the number of threads
+    void slotScreening();
+    // The time of the screening campaign after the one at 'time', or
+    // MAXDOUBLE if there is none
+    Time getNextScreening(Time time) const;
     
 protected : 
+    // The next of the given uniform numbers, or a new one if there are none
+    double draw(const double *&draws) const;
+
+
     bool *typeistarget;
     
     Attribute probdirtreatall;
@@ -53,6 +70,12 @@ protected :
     Attribute notifiertype2;
     Attribute probnotify3;
     Attribute notifiertype3;
+
+    // Screening campaigns; screeningstart is MAXDOUBLE if there are none
+    Time screeningstart;
+    Time screeninginterval;
+    Time screeningend;
+    Attribute probscreening;
     
     Distribution *uniform;
 };
@@ -31,6 +31,8 @@
 
 using namespace std;
 
+SlabAllocator Infection::allocator;
+
 
 
 Infection::Infection(InfectionCreator *creator, Person *_host, 
@@ -43,12 +45,14 @@ Infection::Infection(InfectionCreator *creator, Person *_host,
     
     host = _host;
     parent = _parent;
+    parentinfuid = parent ? parent->infuid : 0;
     ps = _ps;
     
     timeofimmunity = MAXDOUBLE;
     
     if (parent) {
         strainid = parent->getStrainID();
+        parent->children.push_back(this);
     } else {
         strainid = ++global::counterstrainid;
     }
@@ -58,6 +62,8 @@ Infection::Infection(InfectionCreator *creator, Person *_host,
 
     bin = creator->getBinDist()->isample(host,global::abstime);
     
+    global::population->slotRegisterTransmission(this);
+    
     throwEventBinChange();
     throwEventProvokeGPVisit(CauseSymptomsSpecific);
     throwEventProvokeGPVisit(CauseSymptomsGeneral);
@@ -66,17 +72,18 @@ Infection::Infection(InfectionCreator *creator, Person *_host,
 
 Infection::~Infection()
 {
+    // the children lose their parent...
+    for (InfectionList::iterator it = children.begin(); 
+        it != children.end(); it++) {
+        (*it)->parent = 0;
+    }
+    // ...and the parent loses this child
+    if (parent) parent->children.remove(this);
 }
 
 bool Infection::isInfectious() const
 {
-    Bin clearedstate = ((InfectionCreator*)creator)->clearedstate;
-    Bin treatedstate = ((InfectionCreator*)creator)->treatedstate;
-    if (bin == clearedstate || bin == treatedstate) {
-        return(false);
-    } else {
-        return(true);
-    }
+    return(!((InfectionCreator*)creator)->isImmuneBin(bin));
 }
 
 Number Infection::getNumber(NumberOf what) const
@@ -99,10 +106,14 @@ const Infection * Infection::getParent() const
     return(parent);
 };
 
+Counter Infection::getParentInfuid() const
+{
+    return(parentinfuid);
+};
+
 void Infection::throwEventBinChange(bool conditional)
 {
-    if (bin != ((InfectionCreator*)creator)->clearedstate 
-        && bin != ((InfectionCreator*)creator)->treatedstate) {
+    if (!((InfectionCreator*)creator)->isImmuneBin(bin)) {
         Ageable::throwEventBinChange(conditional);
     }
     if (procBinChange.nextTime() >= host->getTimeDeath()) { 
@@ -144,6 +155,14 @@ void Infection::slotBinChange(Bin from, Bin to)
     global::statsinfectionbinchanges++;
     
     host->slotInfectionChangedState(this,from,to);
+    
+    // the infectivity may have changed
+    const PartnershipList *pl = host->getPartnerships();
+    for (PartnershipList::const_iterator it = pl->begin(); 
+        it != pl->end(); it++) {
+        (*it)->internalClearCache();
+        (*it)->throwEventTransmission();
+    }
     if (to == clearedstate || to == treatedstate) {
         // Delete any possible transition out of the these two special states
         timeofimmunity = global::abstime;
@@ -224,42 +243,46 @@ Infection *Infection::clone(Person *newhost, const Partnership *_ps) const
 
 void Infection::slotTryToProgress(Person *victim, const Partnership *ps) 
 {
-    Bin treatedstate = ((InfectionCreator*)creator)->treatedstate;
-    Bin clearedstate = ((InfectionCreator*)creator)->clearedstate;
-    if (bin == treatedstate || bin == clearedstate) return;
+    if (!isTransmissible()) return;
     
-    double factor = getAttribute(
-        ((InfectionCreator*)creator)->inffac, global::abstime
-    );
-    factor *= ((InfectionCreator*)creator)->inffaccouple
-        [host->getType()]
-        [victim->getBinLinearised()]
-        ->dsample(host,global::abstime);
-    factor *= host->getAttribute(
-        ((InfectionCreator*)creator)->inffacinfector,global::abstime
-    );
-    factor *= victim->getAttribute(
-        ((InfectionCreator*)creator)->inffacsusceptible,global::abstime
-    );
-    factor *= ps->getAttribute(
-        ((InfectionCreator*)creator)->inffacps,global::abstime
-    );
-    
-    double p = factor * getAttribute(
-        ((InfectionCreator*)creator)->inf, global::abstime
-    );
+    double p = ps->getTransmissionProbability(this, victim);
     if (((InfectionCreator*)creator)->uniform->dsample() < p) {
         victim->slotInfect(this, ps);
     }
 }
 
+double Infection::getTransmissionProbability(const Person *victim, 
+    const Partnership *ps, bool *constant) const
+{
+    InfectionCreator *ic = (InfectionCreator*)creator;
+    const Distribution *couple = 
+        ic->inffaccouple[host->getType()][victim->getBinLinearised()];
+    
+    double factor = getAttribute(ic->inffac, global::abstime);
+    factor *= couple->dsample(host,global::abstime);
+    factor *= host->getAttribute(ic->inffacinfector,global::abstime);
+    factor *= victim->getAttribute(ic->inffacsusceptible,global::abstime);
+    factor *= ps->getAttribute(ic->inffacps,global::abstime);
+    
+    if (constant) {
+        *constant = isAttributeConstantInBin(ic->inffac)
+            && couple->getPurity() <= PurityTypeBin
+            && host->isAttributeConstantInBin(ic->inffacinfector)
+            && victim->isAttributeConstantInBin(ic->inffacsusceptible)
+            && ps->isAttributeConstantInBin(ic->inffacps)
+            && isAttributeConstantInBin(ic->inf);
+    }
+    
+    return(factor * getAttribute(ic->inf, global::abstime));
+}
+
 string Infection::str() const
 {
     ostringstream s;
     s << "Infection:"
      << "infuid=" << infuid 
      << ",hostpuid=" << host->puid
-     << ",parentinfuid=" << (parent ? parent->infuid : 0);
+     << ",parentinfuid=" << parentinfuid;
     s << "|" << Ageable::str();
     return (s.str());
    
@@ -273,6 +296,7 @@ const Partnership *Infection::getPartnership() const
 
 void Infection::clearParent()
 { 
+    if (parent) parent->children.remove(this);
     parent = 0;
 }
 
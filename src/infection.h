@@ -20,7 +20,10 @@
 #ifndef INFECTIONINFECTION_H
 #define INFECTIONINFECTION_H
 
+#include <vector>
+
 #include "object.h"
+#include "slab.h"
 
 
 
@@ -33,10 +36,27 @@ public:
         const Infection *parent = 0, const Partnership *ps = 0);
 
     ~Infection();
+
+    /**
+     * Objects of this class are allocated from a SlabAllocator
+     * @see getAllocator()
+     */
+    static void *operator new(std::size_t size)
+        { return(allocator.allocate(size)); };
+    static void operator delete(void *p, std::size_t size)
+        { allocator.deallocate(p, size); };
+    /**
+     * Returns the allocator of this class, eg. for statistics
+     * @return a reference to the SlabAllocator
+     */
+    static SlabAllocator &getAllocator() { return(allocator); };
         
     Person *getHost() const;
     const Partnership *getPartnership() const;
     const Infection *getParent() const;
+    // The infuid of the parent, or 0 if none; unlike getParent() this is
+    // kept when the parent is deleted, eg. with a host moved to the spill file
+    Counter getParentInfuid() const;
     void clearParent();
     void clearPartnership();
     Time getTimeOfImmunity();
@@ -46,6 +66,9 @@ public:
     std::string str() const;
     
     bool isInfectious() const;
+    // False if the infection is in a bin where it can not be transmitted,
+    // ie. 'cleared', 'treated' or with an infectiousness of 0
+    bool isTransmissible() const;
 
     virtual Number getNumber(NumberOf what) const;     
     virtual void slotBinChange(Bin from, Bin to);
@@ -54,15 +77,30 @@ public:
     virtual void slotClear();
     virtual void slotTreated();
     virtual void slotTryToProgress(Person *victim, const Partnership *ps);
+    // The probability that a contact in the partnership transmits this
+    // infection to the victim; if 'constant' is given, it is set to whether
+    // the probability changes only with the bins of the infection, the host,
+    // the victim and the partnership (see Partnership::getTransmissionProbability())
+    double getTransmissionProbability(const Person *victim,
+        const Partnership *ps, bool *constant = 0) const;
     virtual void slotProvokeGPVisit();
 
     virtual Infection *clone(Person *newhost, const Partnership *ps = 0) const;
     
 protected:
     
+    static SlabAllocator allocator;
+    
     Person *host;
     const Infection *parent;
+    Counter parentinfuid;
     const Partnership *ps;
+    /** The infections that were passed on by this infection, ie. that have 
+    this infection as their parent; kept up to date by the constructor and the
+    destructor, so that an infection can be deleted without searching the 
+    population for references to it (mutable, as the children only hold a 
+    const reference to their parent) */
+    mutable InfectionList children;
     
     Counter strainid;
     
@@ -84,10 +122,18 @@ public:
 
     Bin getClearedBin() const;
     Bin getTreatedBin() const;
+    /** @return true if 'bin' is the 'cleared' or 'treated' bin */
+    bool isImmuneBin(Bin bin) const 
+        { return((binflags[bin] & BinImmune) != 0); };
+    /** @return true if an infection in 'bin' can be transmitted; false in
+    the immune bins and in bins where the infectiousness is always 0 */
+    bool isTransmissibleBin(Bin bin) const { return(binflags[bin] == 0); };
         
     std::string str() const;
 
     virtual bool getTestResult(Person *person) const;
+    // The same with the uniform number given, eg. drawn in advance
+    virtual bool getTestResult(Person *person, double u) const;
     
     virtual Time getWaitForTestResult(Person *person) const;
     
@@ -119,6 +165,15 @@ private:
 
     Bin clearedstate;
     Bin treatedstate;
+    
+    /** Flags for each bin, set when the configuration is loaded */
+    enum { BinImmune = 1, BinNotInfectious = 2 };
+    std::vector<char> binflags;
 };
 
+inline bool Infection::isTransmissible() const
+{
+    return(((InfectionCreator*)creator)->isTransmissibleBin(bin));
+}
+
 #endif
@@ -113,6 +113,24 @@ name, ROBJ cfg)
 
     clearedstate = getBinByName("cleared");
     treatedstate = getBinByName("treated");
+    
+    // mark the bins in which an infection can not be transmitted, so that
+    // contacts need not evaluate any attribute there; an attribute fixed at
+    // birth for all bins is sampled in bin 0
+    const Distribution * const *attr = global::infectiontypes->getAttributesArray();
+    const bool *isfixed = global::infectiontypes->getAttributesIsFixedArray();
+    const bool *isfixedperbin = 
+        global::infectiontypes->getAttributesIsFixedPerBinArray();
+    Attribute zero[2] = { inf, inffac };
+    binflags.assign(getNumberOfBins(), 0);
+    for (Bin b = 0; b < getNumberOfBins(); b++) {
+        if (b == clearedstate || b == treatedstate) binflags[b] |= BinImmune;
+        for (int i = 0; i < 2; i++) {
+            Attribute a = zero[i];
+            Bin probe = (isfixed[a] && !isfixedperbin[a]) ? 0 : b;
+            if (attr[a]->isZeroInBin(probe)) binflags[b] |= BinNotInfectious;
+        }
+    }
 }
 
 InfectionCreator::~InfectionCreator()
@@ -148,6 +166,11 @@ bool InfectionCreator::randomlyInfectPerson(Person *person, CauseCreation why)
 }
 
 bool InfectionCreator::getTestResult(Person *person) const
+{
+    return(getTestResult(person, testuniform->dsample()));
+}
+
+bool InfectionCreator::getTestResult(Person *person, double u) const
 {
     global::statstests++;
     Infection *infection = person->getInfection(type);
@@ -155,11 +178,9 @@ bool InfectionCreator::getTestResult(Person *person) const
     if (infection 
         && (bin = infection->getBin()) != treatedstate 
         && bin != clearedstate) {
-        double u = testuniform->dsample();
         double p = infection->getAttribute(testsensitivity, global::abstime);
         return(u < p);
     } else {
-        double u = testuniform->dsample();
         double p = person->getAttribute(testspecificity, global::abstime);
         return(u > p);
     }
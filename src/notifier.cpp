@@ -23,6 +23,7 @@
 #include "person.h"
 #include "partnership.h"
 #include <iostream>
+#include <algorithm>
 using namespace std;
 
 Notifier::Notifier(CreatorCollection *collection, std::string name, ROBJ cfg)
@@ -114,8 +115,6 @@ void Notifier::notifyPartners(Person *person, Notification notif)
     // This is for the partners; the link number of the person is already 
     // set at the GP visit
 
-
-        
     double puseor = person->getAttribute(useorforgoback);
     double howmuch = person->getAttribute(gobacktime);
     int howmany = floor(person->getAttribute(gobackpartners));
@@ -123,83 +122,53 @@ void Notifier::notifyPartners(Person *person, Notification notif)
     const PartnershipList *ps = person->getPartnerships();
     for(PartnershipList::const_iterator it = ps->begin(); 
         it != ps->end(); it++) {
-        Person *partner = (*it)->getPartner(person);
-        if (!partner->isNotifiedAlready(notif)) {
-            partner->setLinkNumber(newnotif.linknumber);
-            double facsender = person->getAttribute(probabilityfactorsender);
-            double facreceiver =  partner->getAttribute(probabilityfactorreceiver);
-            double facpartnership = (*it)->getAttribute(probabilityfactorpartnership);
-            double prob = probabilitycouple[person->getType()]
-                [partner->getBinLinearised()]->dsample(person, global::abstime);
-            prob *= facsender*facreceiver*facpartnership;
-            double u = uniform->dsample();
-            if (u < prob) {
-                double fac = 
-                    person->getAttribute(waitfacsender)
-                    *partner->getAttribute(waitfacreceiver);
-                Time wait = waitreaction[person->getType()]
-                    [partner->getBinLinearised()]->dsamplefac(
-                        fac,person,global::abstime
-                    );
-                Type gpv = (int)floor(partner->getAttribute(gpvisittype));
-    /*            cout << "(active) ";*/
-                person->slotNotifyingPartner(partner, *it, this, notif);
-                partner->slotVisitGPNotified(gpv, wait, newnotif);
-            }
-        }
+        notifyPartner(person, *it, notif, newnotif);
     }
     
     ps = person->getPartnershipsOld();
     
-    int countps = 0;
-    
     double uuseor = uniform->dsample();
     
-    for(PartnershipList::const_iterator it = ps->begin(); 
-        it != ps->end(); it++) {
-        countps++;
-        /* check if partnership complies neither with gobacktime 
-         nor gobackpartners */
-        if (
-            ( (uuseor > puseor) 
-              && ((countps > howmany) 
-                  && ((*it)->getTimeDeath() < global::abstime - howmuch)) 
-            ) 
-            || 
-            (
-              (uuseor <= puseor)          
-              && ((countps > howmany) 
-                  || ((*it)->getTimeDeath() < global::abstime - howmuch))
-            )
-           ) 
-        {
-            break; // we can stop here, because if this ps does not comply    
-                   // neither won't earlier ones
-        }
-                
-        Person *partner = (*it)->getPartner(person);
-        if (!partner->isNotifiedAlready(notif)) {        
-            partner->setLinkNumber(newnotif.linknumber);
-            double facsender = person->getAttribute(probabilityfactorsender);
-            double facreceiver =  partner->getAttribute(probabilityfactorreceiver);
-            double facpartnership = (*it)->getAttribute(probabilityfactorpartnership);
-            double prob = probabilitycouple[person->getType()]
-                [partner->getBinLinearised()]->dsample(person, global::abstime);
-            prob *= facsender*facreceiver*facpartnership;
-            double u = uniform->dsample();
-            if (u < prob) {
-                double fac = 
-                    person->getAttribute(waitfacsender)
-                    *partner->getAttribute(waitfacreceiver);
-                Time wait = waitreaction[person->getType()]
-                    [partner->getBinLinearised()]->dsamplefac(
-                        fac,person,global::abstime
-                    );
-                Type gpv = (int)floor(partner->getAttribute(gpvisittype));
-                person->slotNotifyingPartner(partner, *it, this, notif);
-                partner->slotVisitGPNotified(gpv, wait, newnotif);
-            }
-        }
+    /* the old partnerships are sorted by the time they ended, so those
+     complying with gobacktime and those complying with gobackpartners are
+     both a range at the end of the list; with 'or', a partnership has to
+     comply with either of them, otherwise with both */
+    int n = ps->size();
+    int sincetime = person->getPartnershipsOldSince(global::abstime - howmuch);
+    int sincecount = max(n - howmany, 0);
+    int first = (uuseor > puseor) ? min(sincetime, sincecount) 
+                                  : max(sincetime, sincecount);
+    
+    // the most recent first
+    for (int i = n - 1; i >= first; i--) {
+        notifyPartner(person, (*ps)[i], notif, newnotif);
     }
 }
 
+void Notifier::notifyPartner(
+    Person *person, Partnership *ps, Notification notif, Notification newnotif
+)
+{
+    Person *partner = ps->getPartner(person);
+    if (partner->isNotifiedAlready(notif)) return;
+    partner->setLinkNumber(newnotif.linknumber);
+    double facsender = person->getAttribute(probabilityfactorsender);
+    double facreceiver =  partner->getAttribute(probabilityfactorreceiver);
+    double facpartnership = ps->getAttribute(probabilityfactorpartnership);
+    double prob = probabilitycouple[person->getType()]
+        [partner->getBinLinearised()]->dsample(person, global::abstime);
+    prob *= facsender*facreceiver*facpartnership;
+    double u = uniform->dsample();
+    if (u < prob) {
+        double fac = 
+            person->getAttribute(waitfacsender)
+            *partner->getAttribute(waitfacreceiver);
+        Time wait = waitreaction[person->getType()]
+            [partner->getBinLinearised()]->dsamplefac(
+                fac,person,global::abstime
+            );
+        Type gpv = (int)floor(partner->getAttribute(gpvisittype));
+        person->slotNotifyingPartner(partner, ps, this, notif);
+        partner->slotVisitGPNotified(gpv, wait, newnotif);
+    }
+}
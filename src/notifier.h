@@ -37,6 +37,11 @@ public:
     std::string getBasetype() const { return("GENERIC"); };
     
 protected : 
+    // Notifies the partner of 'person' in the partnership 'ps' with the
+    // probability given by the attributes
+    void notifyPartner(Person *person, Partnership *ps, Notification notif,
+        Notification newnotif);
+
     Attribute useorforgoback;
     Attribute gobacktime;
     Attribute gobackpartners;
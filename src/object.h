@@ -210,6 +210,18 @@ protected:
     /** An array with pointers to the distributions that are used to sample the
     next bin transition (con- and destructed by this Creator) */
     Distribution **bintransdist;
+    /** The number of transitions going out of each bin (con- and destructed
+    by this Creator) */
+    Number *bintransoutnum;
+    /** For each bin an array with the numbers of the transitions going out of
+    it, so that the other transitions need not be looked at when sampling the
+    next bin change (con- and destructed by this Creator) */
+    int **bintransout;
+    /** For each bin the total rate of the transitions going out of it, if all
+    of them are plain exponential distributions; otherwise negative (con- and
+    destructed by this Creator)
+    @see Ageable::sampleBinChange() */
+    double *bintransoutrate;
    
     /**
      * Created a PairAttribute. These attributes are not installed at the
@@ -374,6 +386,16 @@ public:
      * @see Ageable::installAttribute(); Distribution::dsample()
      */
     Value getAttribute(Attribute attribute, Time now, Value atleast) const;
+    /**
+     * Checks whether an Attribute of this Ageable always gives the same value
+     * as long as the bin does not change, ie. whether it is fixed at birth or
+     * cached (see CreatorCollection::getAttributesCacheArray()); such values
+     * may be kept by the caller until the next bin change
+     * @param attribute an Attribute object representing the attribute
+     * @return 'true' if the value changes only with the bin
+     */
+    bool isAttributeConstantInBin(Attribute attribute) const
+        { return(attrisfixed[attribute] || attrcache[attribute] != 0); };
     /**
      * Sample from an Attribute belonging to this Ageable, assuming the current
      * time being 'now', scaled by a factor; it depends on the distribution
@@ -436,8 +458,25 @@ public:
      * @param to the bin in which the Ageable should change
      */
     virtual void slotBinChange(Bin from, Bin to);
+    /**
+     * Returns the number of values of Attributes fixed at birth that are
+     * stored by this Ageable
+     * @return the number of values in 'attrfixed'
+     */
+    Number getNumberOfFixedValues() const;
     
 protected:
+    /**
+     * Returns the place in 'attrfixed' where the value of a fixed Attribute is
+     * stored
+     * @param a the Attribute, which has to be fixed at birth
+     * @param b the bin for which the value is requested
+     * @return a reference into 'attrfixed'
+     */
+    Value &getFixedAttribute(Attribute a, Bin b) const
+        { return(attrisfixedperbin[a] ? 
+            attrfixed[attrfixedperbinpos + attrfixedindex[a]*binnum + b] :
+            attrfixed[attrfixedindex[a]]); };
     /** the time of birth
      * @see getTimeBirth() */
     Time timebirth;
@@ -458,22 +497,49 @@ protected:
     /** 
      * An array with the values with the 'fixatbirth' or 'fixatbirthbybin'
      * features; if an Attribute has this feature activated, the value is not
-     * sampled from the corresponding distributino but taken from this double
-     * array; first index is the Attribute number the second index the current
-     * bin of the Ageable (array is created and destructed by the Ageable) */
-    Value **attrfixed;
+     * sampled from the corresponding distributino but taken from this array.
+     * All values are stored in one block: first one value for each Attribute
+     * fixed at birth, then 'binnum' values for each Attribute fixed by bin;
+     * Attributes that are not fixed take no space (array is created and
+     * destructed by the Ageable)
+     * @see Ageable::getFixedAttribute() */
+    Value *attrfixed;
     /** 
      * A pointer to an array specifying which Attribute is fixed at birth; the
      * array is managed by the corresponding CreatorCollection object
      * @see CreatorCollection::getAttributesIsFixedArray()
      */
     const bool *attrisfixed;
+    /** 
+     * A pointer to an array specifying which Attribute is fixed by bin; the
+     * array is managed by the corresponding CreatorCollection object
+     * @see CreatorCollection::getAttributesIsFixedPerBinArray()
+     */
+    const bool *attrisfixedperbin;
+    /** 
+     * A pointer to an array with the position of the fixed Attributes in
+     * 'attrfixed'; the array is managed by the corresponding
+     * CreatorCollection object
+     * @see CreatorCollection::getAttributesFixedIndexArray()
+     */
+    const int *attrfixedindex;
+    /** the position in 'attrfixed' of the first value fixed by bin */
+    int attrfixedperbinpos;
     /**
      * A pointer to an array representing the distribution from which to
      * sample; the index is the Attribute number; the array is managed by the
      * corresponding CreatorCollection object 
      */
     const Distribution * const *attr;
+    /**
+     * A pointer to an array with the cached values of the Attributes that
+     * are neither fixed nor random but only depend on type and bin; the index
+     * is the Attribute number, then the linearised bin; an entry of 0 means
+     * that the Attribute is not cached; the array is managed by the
+     * corresponding CreatorCollection object 
+     * @see CreatorCollection::getAttributesCacheArray()
+     */
+    Value * const *attrcache;
     
     /** A Process object which manages the event flow of bin changes 
      * @see Ageable::throwEventBinChange() 
@@ -694,6 +760,21 @@ public:
      * @return a pointer to a single indexed array
      */
     const bool *getAttributesIsFixedPerBinArray() const;
+    /**
+     * Returns a pointer to an array with the position of each fixed Attribute
+     * among the fixed Attributes of its kind (fixed per bin or overall); the
+     * entry is NA for Attributes that are not fixed
+     * @return a pointer to a single indexed array
+     * @see Ageable::attrfixed
+     */
+    const int *getAttributesFixedIndexArray() const;
+    /**
+     * Returns the number of Attributes fixed at birth
+     * @param perbin if true, the number of Attributes fixed per bin, otherwise
+     * the number of those fixed independent of the bin
+     * @return the number of Attributes
+     */
+    Number getNumberOfFixedAttributes(bool perbin) const;
     /**
      * Returns a pointer to an array that contains the distributions for each
      * Attribute
@@ -701,6 +782,33 @@ public:
      * Distribution objects.
      */
     const Distribution * const *getAttributesArray() const; 
+    /**
+     * Returns a pointer to an array that contains for each Attribute its
+     * classification by what its samples depend on; the classification is done
+     * when the Attribute is installed
+     * @return a pointer to a single indexed array
+     * @see Distribution::getPurity()
+     */
+    const Purity *getAttributesPurityArray() const;
+    /**
+     * Returns a pointer to an array with the cached values of the Attributes;
+     * Attributes that are not fixed at birth but whose distribution is a
+     * function of type and bin only (see getAttributesPurityArray()) are
+     * evaluated only once for every type/bin combination and stored in a 
+     * double indexed array: first index is the Attribute, second the
+     * linearised bin (see linearise()); the values are initialised to NA and 
+     * filled in by Ageable::getAttribute() on first use; for all other
+     * Attributes the entry is 0. The caches are allocated on the first call,
+     * so this must not be called before all Creators are registered.
+     * @return a pointer to a single indexed array of arrays
+     */
+    Value * const *getAttributesCacheArray();
+    /**
+     * Returns the number of values held in the caches of the Attributes
+     * @return the number of values
+     * @see getAttributesCacheArray()
+     */
+    Number getNumberOfCachedValues() const;
     /**
      * Returns the distribution that corresponds to the Attribute given by the
      * 'attr' argument.
@@ -751,6 +859,23 @@ private:
     at birth by bin independent of the bin (con- and destructed of the array is
     automatically) */
     bool attrisfixedperbin[MAXNEWATTRIBUTES];
+    /** An array with the position of each fixed attribute among the fixed
+    attributes of its kind, see getAttributesFixedIndexArray() (con- and
+    destructed of the array is automatically) */
+    int attrfixedindex[MAXNEWATTRIBUTES];
+    /** the number of attributes fixed at birth independent of the bin */
+    int attrfixednum;
+    /** the number of attributes fixed at birth by bin */
+    int attrfixedperbinnum;
+    /** An array with the classification of the attributes managed by this
+    collection (con- and destructed of the array is automatically) */
+    Purity attrpurity[MAXNEWATTRIBUTES];
+    /** An array with the cached values of the attributes, see 
+    getAttributesCacheArray() (the arrays are created on first use and deleted
+    by preDelete()) */
+    Value *attrcache[MAXNEWATTRIBUTES];
+    /** true after the caches in 'attrcache' have been allocated */
+    bool attrcacheready;
     /** the number of attributes managed by this collection */
     int attrnum;
     
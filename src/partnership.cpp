@@ -29,8 +29,12 @@
 #include "population.h"
 #include "event.h"
 
+#include <algorithm>
+
 using namespace std;
 
+SlabAllocator Partnership::allocator;
+
 
 Partnership::Partnership(
     PSCreator *_psc, 
@@ -50,11 +54,17 @@ Partnership::Partnership(
     timebirth = _start;
     timedeath = _start+_breakup;
     psfinfo = _psfinfo;
+    aggregated = false;
+    nextunprotected = false;
+    nextcontact = MAXDOUBLE;
+    contactfactorcache = NA_REAL;
+    unprotectedcache = NA_REAL;
     psid = global::population->slotRegisterPartnership(this);
     p1->slotRegisterPartnership(this);
     p2->slotRegisterPartnership(this);
     throwEventDeath();
     throwEventHaveSex();
+    throwEventTransmission();
     throwEventBinChange();
 }
 
@@ -79,6 +89,8 @@ Number Partnership::getNumber(NumberOf what) const
 
 void Partnership::slotDeath() 
 {   
+    internalCountContacts();
+    procTransmission.clear();
     Ageable::slotDeath();
     p1->slotDeregisterPartnership(this);
     p2->slotDeregisterPartnership(this);    
@@ -90,15 +102,32 @@ void Partnership::slotHaveSex(bool unprotected)
     contacts++;
     global::statscontacts++;
     if (unprotected) { unprotectedcontacts++; global::statscontactsunprot++; }
+    if (global::hazardtransmission) {
+        // the transmissions have their own events
+        p1->slotNotifyHaveContact(this, unprotected);
+        p2->slotNotifyHaveContact(this, unprotected);
+        throwEventHaveSex();
+        return;
+    }
+    // infections in a bin where they can not be transmitted are skipped
+    // without evaluating any attribute
     const InfectionList *dl = p1->getInfections();
     for (InfectionList::const_iterator it = dl->begin(); 
         it != dl->end(); it++) {
-        (*it)->slotTryToProgress(p2, this);   
+        if ((*it)->isTransmissible()) {
+            (*it)->slotTryToProgress(p2, this);
+        } else {
+            global::statstransmissionsskipped++;
+        }
     }
     dl = p2->getInfections();
     for (InfectionList::const_iterator it = dl->begin(); 
         it != dl->end(); it++) {
-        (*it)->slotTryToProgress(p1, this);   
+        if ((*it)->isTransmissible()) {
+            (*it)->slotTryToProgress(p1, this);
+        } else {
+            global::statstransmissionsskipped++;
+        }
     }
     p1->slotNotifyHaveContact(this, unprotected);
     p2->slotNotifyHaveContact(this, unprotected);
@@ -112,34 +141,159 @@ void Partnership::throwEventBinChange(bool conditional)
 
 void Partnership::slotBinChange(Bin from, Bin to)
 {
+    // the aggregated contacts up to now are counted with the old bin, as
+    // their events would have been sampled with it
+    internalCountContacts();
     Ageable::slotBinChange(from, to);
     global::statspartnershipbinchanges++;
+    internalClearCache();
     throwEventHaveSex(true);
+    throwEventTransmission();
 }
 
-void Partnership::throwEventHaveSex(bool conditional)
+void Partnership::slotUpdateContacts()
 {
-    Time time;
+    throwEventTransmission();
+    if (!aggregated || 
+        (!p1->hasContactEffects(p2) && !p2->hasContactEffects(p1))) return;
+    internalCountContacts();
+    aggregated = false;
+    // the next contact is sampled already, it only needs its event now
+    if (nextcontact < MAXDOUBLE) {
+        procHaveSex.update(new EventHaveSex(nextcontact, this, nextunprotected));
+    }
+}
+
+void Partnership::slotTransmission(Infection *infection, Person *victim)
+{
+    procTransmission.setLastTime();
+    victim->slotInfect(infection, this);
+    throwEventTransmission();
+}
+
+void Partnership::throwEventTransmission()
+{
+    if (!global::hazardtransmission) return;
     
-    double factor = getAttribute(
-        ((PSCreator*)creator)->contactfactor, global::abstime
-    );
+    // each infectious infection of a partner that the other partner does not
+    // have is transmitted at rate (contact rate) * (probability per contact);
+    // the first of these transmissions is scheduled
+    Time first = MAXDOUBLE;
+    Infection *infection = 0;
+    Person *victim = 0;
+    Person *partners[2] = { p1, p2 };
+    for (int i = 0; i < 2; i++) {
+        const InfectionList *il = partners[i]->getInfections();
+        Person *other = partners[1-i];
+        for (InfectionList::const_iterator it = il->begin(); 
+            it != il->end(); it++) {
+            if (!(*it)->isTransmissible() || 
+                other->getInfection((*it)->getType()))
+                continue;
+            double p = min(getTransmissionProbability(*it, other), 1.0);
+            if (p <= 0) continue;
+            Time time = global::abstime + 
+                getAttributeFac(((PSCreator*)creator)->contact,
+                    global::abstime, getContactFactor(global::abstime) * p);
+            if (time < first) {
+                first = time;
+                infection = *it;
+                victim = other;
+            }
+        }
+    }
+    
+    if (first < getTimeDeath()) {
+        procTransmission.update(
+            new EventTransmission(first, this, infection, victim));
+    } else {
+        procTransmission.clear();
+    }
+}
+
+double Partnership::getContactFactor(Time now) const
+{
+    if (!ISNAN(contactfactorcache)) return(contactfactorcache);
+    
+    PSCreator *psc = (PSCreator*)creator;
     Type p1type = p1->getType();
     int p2index = global::persontypes->linearise(p2->getType(),p2->getBin());
+    const Distribution *couple = psc->contactcouplefactor[p1type][p2index];
     
-    double factor2 = ((PSCreator*)creator)->contactcouplefactor[p1type][p2index]
-        ->dsample(p1,global::abstime);
-    factor *= factor2;
+    double factor = getAttribute(psc->contactfactor, now);
+    factor *= couple->dsample(p1,now);
+    factor *= p1->getAttribute(psc->contactfactorperson1, now);
+    factor *= p2->getAttribute(psc->contactfactorperson2, now);
     
-    double factor3 = p1->getAttribute(
-        ((PSCreator*)creator)->contactfactorperson1, global::abstime
-    );
-    factor *= factor3;
+    // keep the value until the next bin change if no factor is random
+    if (isAttributeConstantInBin(psc->contactfactor)
+        && couple->getPurity() <= PurityTypeBin
+        && p1->isAttributeConstantInBin(psc->contactfactorperson1)
+        && p2->isAttributeConstantInBin(psc->contactfactorperson2)) {
+        contactfactorcache = factor;
+    }
+    return(factor);
+}
+
+double Partnership::getUnprotectedProbability(Time now) const
+{
+    if (!ISNAN(unprotectedcache)) return(unprotectedcache);
     
-    double factor4 = p2->getAttribute(
-        ((PSCreator*)creator)->contactfactorperson2, global::abstime
-    );
-    factor *= factor4;
+    PSCreator *psc = (PSCreator*)creator;
+    Type p1type = p1->getType();
+    int p2index = global::persontypes->linearise(p2->getType(),p2->getBin());
+    const Distribution *couple = psc->unprotectedcouplefactor[p1type][p2index];
+    
+    double prob = getAttribute(psc->unprotected, now);
+    prob *= getAttribute(psc->unprotectedfactor, now);
+    prob *= couple->dsample(p1,now);
+    prob *= p1->getAttribute(psc->unprotectedfactorperson1, now);
+    prob *= p2->getAttribute(psc->unprotectedfactorperson2, now);
+    
+    if (isAttributeConstantInBin(psc->unprotected)
+        && isAttributeConstantInBin(psc->unprotectedfactor)
+        && couple->getPurity() <= PurityTypeBin
+        && p1->isAttributeConstantInBin(psc->unprotectedfactorperson1)
+        && p2->isAttributeConstantInBin(psc->unprotectedfactorperson2)) {
+        unprotectedcache = prob;
+    }
+    return(prob);
+}
+
+double Partnership::getTransmissionProbability(const Infection *infection,
+    const Person *victim) const
+{
+    for (vector<TransmissionProbability>::const_iterator it = 
+        transmissioncache.begin(); it != transmissioncache.end(); it++) {
+        if (it->infection == infection && it->victim == victim) return(it->p);
+    }
+    bool constant;
+    double p = infection->getTransmissionProbability(victim, this, &constant);
+    if (constant) {
+        TransmissionProbability tp = { infection, victim, p };
+        transmissioncache.push_back(tp);
+    }
+    return(p);
+}
+
+void Partnership::internalClearCache()
+{
+    contactfactorcache = NA_REAL;
+    unprotectedcache = NA_REAL;
+    transmissioncache.clear();
+}
+
+void Partnership::throwEventHaveSex(bool conditional)
+{
+    Time time;
+    
+    // contacts that can have no effect are only counted when needed, if
+    // enabled; this is decided anew for each contact
+    if (aggregated) internalCountContacts();
+    aggregated = global::aggregatecontacts &&
+        !p1->hasContactEffects(p2) && !p2->hasContactEffects(p1);
+    
+    double factor = getContactFactor(global::abstime);
     
     if (conditional) {
         Time timediff = global::abstime - procHaveSex.lastTime();
@@ -159,33 +313,55 @@ void Partnership::throwEventHaveSex(bool conditional)
     
     if (time < getTimeDeath()) {
         // Sample whether unprotected
-        double prob = getAttribute(
-            ((PSCreator*)creator)->unprotected, global::abstime
-        );
-        prob *= getAttribute(
-            ((PSCreator*)creator)->unprotectedfactor, global::abstime
-        );
-        prob *= ((PSCreator*)creator)->unprotectedcouplefactor[p1type][p2index]
-                ->dsample(p1,global::abstime);
-        prob *= p1->getAttribute(
-            ((PSCreator*)creator)->unprotectedfactorperson1, global::abstime
-        );
-        prob *= p2->getAttribute(
-            ((PSCreator*)creator)->unprotectedfactorperson2, global::abstime
-        );
+        double prob = getUnprotectedProbability(global::abstime);
+        bool unprotected = 
+            ((PSCreator*)creator)->uniform->dsample(this, global::abstime)<prob;
         
-        if (((PSCreator*)creator)->uniform->dsample(this, global::abstime)<prob)
-        {
-            procHaveSex.replace(new EventHaveSex(time, this, true));
+        if (aggregated) {
+            nextcontact = time;
+            nextunprotected = unprotected;
+            procHaveSex.clear();
+            procHaveSex.setLastTime();
         } else {
-            procHaveSex.replace(new EventHaveSex(time, this, false));
+            procHaveSex.replace(new EventHaveSex(time, this, unprotected));
         }
         
     } else {
+        nextcontact = MAXDOUBLE;
         procHaveSex.clear();
     }
 }
 
+void Partnership::internalCountContacts()
+{
+    if (!aggregated) return;
+    // the same as if each contact had its EventHaveSex, except that the
+    // attributes are evaluated at the time of the contact instead of when the
+    // event is scheduled
+    while (nextcontact <= global::abstime) {
+        Time time = nextcontact;
+        contacts++;
+        global::statscontacts++;
+        if (nextunprotected) { 
+            unprotectedcontacts++; 
+            global::statscontactsunprot++; 
+        }
+        p1->slotNotifyHaveContact(this, nextunprotected);
+        p2->slotNotifyHaveContact(this, nextunprotected);
+        procHaveSex.setLastTime(time);
+        
+        nextcontact = time + getAttributeFac(((PSCreator*)creator)->contact,
+            time, getContactFactor(time));
+        if (nextcontact < getTimeDeath()) {
+            double prob = getUnprotectedProbability(time);
+            nextunprotected = 
+                ((PSCreator*)creator)->uniform->dsample(this, time) < prob;
+        } else {
+            nextcontact = MAXDOUBLE;
+        }
+    }
+}
+
 string Partnership::str() const
 {
     ostringstream s;
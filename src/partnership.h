@@ -21,10 +21,12 @@
 #ifndef PARTNERSHIP_H
 #define PARTNERSHIP_H
 
+#include <deque>
 #include <vector>
 #include <string>
 
 #include "object.h"
+#include "slab.h"
 
 
 class PSCreator : public Creator
@@ -101,7 +103,10 @@ public:
     std::string getBasetype() const { return("INDIVIDUALSEARCH"); };
     
 private:    
-    std::vector<Process *> procPSForm;
+    // The formation process of each person, indexed by PopID.pos_v; a deque 
+    // because growing it must not copy processes with a scheduled event
+    std::deque<Process> procPSForm;
+    std::vector<char> procPSFormActive;
     
 //     std::vector<Event *> nextpsformevent;
     bool *typeisactive;
@@ -133,6 +138,20 @@ public:
 
     ~Partnership();
 
+    /**
+     * Objects of this class are allocated from a SlabAllocator
+     * @see getAllocator()
+     */
+    static void *operator new(std::size_t size)
+        { return(allocator.allocate(size)); };
+    static void operator delete(void *p, std::size_t size)
+        { allocator.deallocate(p, size); };
+    /**
+     * Returns the allocator of this class, eg. for statistics
+     * @return a reference to the SlabAllocator
+     */
+    static SlabAllocator &getAllocator() { return(allocator); };
+
     PartnershipID getPartnershipID() const;    
     Person *getPerson1() const;
     Person *getPerson2() const;
@@ -145,20 +164,61 @@ public:
     virtual void slotDeath();
     virtual void slotHaveSex(bool unprotected);
     virtual void slotBinChange(Bin from, Bin to);
+    // Called when one of the partners got infected; resamples the next
+    // transmission, and if the contacts were only counted so far, they are
+    // simulated individually from now on
+    virtual void slotUpdateContacts();
+    // Called by EventTransmission
+    virtual void slotTransmission(Infection *infection, Person *victim);
         
     virtual void throwEventHaveSex(bool conditional = false);
+    // Samples the next transmission from the infections of the partners (see
+    // global::hazardtransmission); needs to be called whenever an infection,
+    // a partner or the partnership changes
+    virtual void throwEventTransmission();
     virtual void throwEventBinChange(bool conditional = false);
 
+    // If the contacts are not simulated individually (see
+    // global::aggregatecontacts), counts the contacts that happened up to now
+    void internalCountContacts();
+    // The probability that a contact transmits the infection to the victim;
+    // kept until internalClearCache() if it depends on the bins only
+    double getTransmissionProbability(const Infection *infection,
+        const Person *victim) const;
+    // Forgets the cached factors; must be called when the bin of the
+    // partnership, a partner or one of their infections changes
+    void internalClearCache();
+
     virtual std::string str() const;
     
 private:
+    static SlabAllocator allocator;
     Person *p1, *p2;
     PartnershipID psid;
     PSFInfo psfinfo;
     Process procHaveSex;
+    Process procTransmission;
     Number contacts;
     Number unprotectedcontacts;
-    
+    // If true, there is no EventHaveSex and the next contact is kept here
+    bool aggregated;
+    bool nextunprotected;
+    Time nextcontact;
+    
+    // The factor of the contact rate and the probability of unprotected
+    // contacts; NA if not computed yet or if random or changing with time
+    mutable Value contactfactorcache;
+    mutable Value unprotectedcache;
+    // The transmission probabilities that depend on the bins only
+    typedef struct {
+        const Infection *infection;
+        const Person *victim;
+        Value p;
+    } TransmissionProbability;
+    mutable std::vector<TransmissionProbability> transmissioncache;
+    
+    double getContactFactor(Time now) const;
+    double getUnprotectedProbability(Time now) const;
 };
 
 
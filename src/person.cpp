@@ -21,6 +21,7 @@
 #include "person.h"
 #include "distribution.h"
 #include <string>
+#include <algorithm>
 #include "rif.h"
 #include "constants.h"
 #include "event.h"
@@ -35,6 +36,8 @@
 
 using namespace std;
 
+SlabAllocator Person::allocator;
+
 //
 // BEGIN IMPLEMENTATION OF CLASS Person
 //
@@ -47,14 +50,16 @@ PersonMale *_father)
     idsubclass = CLASSPERSONGENERIC;
     puid = ++global::counterpuid;
     causeCreated = why;
-    mother = _mother;
-    father = _father;
+    motherpuid = _mother ? _mother->puid : 0;
+    fatherpuid = _father ? _father->puid : 0;
     partnerscurrent = 0;
     partnerstotal = 0;
     contacts = 0;
     contactsunprot = 0;
     infectionscurrent = 0;
     infectionstotal = 0;
+    partnershipsexpired = 0;
+    infectionsexpired = 0;
     gpvisits = 0;
     notifications = 0;
     alreadynotified = 0;
@@ -204,14 +209,34 @@ const PartnershipList *Person::getPartnershipsOld() const
     return(&partnershipsold);
 }
 
-const SingleNotificationList *Person::getSingleNotifications() const
+static bool endedBefore(const Partnership *ps, Time time)
+{
+    return(ps->getTimeDeath() < time);
+}
+
+unsigned int Person::getPartnershipsOldSince(Time time) const
+{
+    return(lower_bound(partnershipsold.begin(), partnershipsold.end(), time,
+        endedBefore) - partnershipsold.begin());
+}
+
+const NotificationList *Person::getNotifications() const
 {
-    return(&singlenotiflist);
+    return(&notiflist);
 }
 
-const SingleGPVisitList *Person::getSingleGPVisits() const
+void Person::internalExpireWithin() const
 {
-    return(&singlegpvisitlist);
+    while (partnershipsexpired < partnershipsold.size() && 
+        global::abstime - partnershipsold[partnershipsexpired]->getTimeDeath()
+            >= global::withintimelag) {
+        partnershipsexpired++;
+    }
+    while (infectionsexpired < infectionsold.size() && 
+        global::abstime - infectionsold[infectionsexpired]->getTimeDeath()
+            >= global::withintimelag) {
+        infectionsexpired++;
+    }
 }
 
 Number Person::getNumber(NumberOf what) const
@@ -256,30 +281,20 @@ Number Person::getNumber(NumberOf what) const
         }
         case NumberOfPartnersTotal:
             return(partnerstotal);
-        case NumberOfPartnersWithin: {
-            Number n = partnerscurrent;
-            for(PartnershipList::const_iterator it = partnershipsold.begin();
-                it != partnershipsold.end(); it++) {
-                if ((global::abstime-(*it)->getTimeDeath())
-                      <global::withintimelag)
-                  n++;
-            }
-            return(n);
-        }
+        case NumberOfPartnersWithin:
+            internalExpireWithin();
+            return(partnerscurrent + 
+                partnershipsold.size() - partnershipsexpired);
         case NumberOfContacts :
             return(contacts);
         case NumberOfContactsUnprotected : 
             return(contactsunprot);
         case NumberOfInfectionsCurrent :
             return(infectionscurrent);
-        case NumberOfInfectionsWithin : {
-            Number n = infectionscurrent;
-            for(InfectionList::const_iterator it = infectionsold.begin();
-                it != infectionsold.end(); it++) {
-                if (global::abstime-(*it)->getTimeDeath()<global::withintimelag) n++;
-            }
-            return(n);
-        }
+        case NumberOfInfectionsWithin :
+            internalExpireWithin();
+            return(infectionscurrent + 
+                infectionsold.size() - infectionsexpired);
         case NumberOfInfectionsTotal :
             return(infectionstotal);
         case NumberOfLink : 
@@ -376,23 +391,32 @@ void Person::slotTreat(Type infectiontype, Time wait)
     }
 }
 
+static bool notifLess(const Notification &a, const Notification &b)
+{
+    return(a.nid < b.nid);
+}
+
 bool Person::isNotifiedAlready(Notification notif) {
-    for (NotificationList::iterator it = notiflist.begin();
-        it != notiflist.end(); it++) {
-        if ((*it).nid == notif.nid) {
-            return(true);   
-        }
-    }
-    return(false);
+    return(binary_search(
+        notiflist.begin(), notiflist.end(), notif, notifLess));
+}
+
+bool Person::registerNotification(Notification notif)
+{
+    // the chains are not notified in the order of their nid, so insert
+    // at the right place to keep the list sorted
+    NotificationList::iterator it = lower_bound(
+        notiflist.begin(), notiflist.end(), notif, notifLess);
+    if (it != notiflist.end() && (*it).nid == notif.nid) return(false);
+    notiflist.insert(it, notif);
+    notifications++;
+    return(true);
 }
 
 void Person::slotNotificationStarts(Notification notif)
 {
     alreadynotified = 0;
-    if (!isNotifiedAlready(notif)) {
-        notiflist.push_front(notif);
-        notifications++;
-    }    
+    registerNotification(notif);
 }    
    
 void Person::slotNotifyingPartner(
@@ -417,7 +441,7 @@ void Person::slotNotifyingPartner(
     sn.pstype = ps->getType(); 
     sn.psbin = ps->getBinLinearised();
     
-    singlenotiflist.push_front(sn);
+    global::population->slotRegisterNotification(sn);
 
     alreadynotified++;
 }
@@ -427,11 +451,8 @@ void Person::slotVisitGPNotified(
 )
 {
     
-    if (isNotifiedAlready(notif)) return;
-    
-    // no, so store
-    notiflist.push_front(notif);
-    notifications++;
+    // store, unless already notified
+    if (!registerNotification(notif)) return;
     
     // set next event
     global::statsfollowupvisits++;
@@ -465,7 +486,7 @@ void Person::slotVisitGP(
           (GPVisitCreator*)(global::gpvisittypes->getCreator(gpvisittype));
       SingleGPVisit gpv = gc->makeVisit(this, notif);
       gpv.cause = cvgp;
-      singlegpvisitlist.push_front(gpv);
+      global::population->slotRegisterGPVisit(gpv);
       gpvisits++;
     }
     throwEventVisitGP();
@@ -475,7 +496,7 @@ void Person::slotVisitGP(
         (GPVisitCreator*)(global::gpvisittypes->getCreator(gpvisittype));
     SingleGPVisit gpv = gc->makeVisit(this, notif);
     gpv.cause = cvgp;
-    singlegpvisitlist.push_front(gpv);
+    global::population->slotRegisterGPVisit(gpv);
     gpvisits++;
   } else if (cvgp==CauseNotified) {
     positivetests = 0;
@@ -483,13 +504,24 @@ void Person::slotVisitGP(
         (GPVisitCreator*)(global::gpvisittypes->getCreator(gpvisittype));
     SingleGPVisit gpv = gc->makeVisit(this, notif);
     gpv.cause = cvgp;
-    singlegpvisitlist.push_front(gpv);
+    global::population->slotRegisterGPVisit(gpv);
     gpvisits++;
     throwEventVisitGP();
   } else {
     rif_error(creator->getCfg(),"internal: unknown CauseVisitGP in Person::slotVisitGP");
   }
 }
+
+void Person::slotScreened(Type gpvisittype, const double *draws)
+{
+    positivetests = 0;
+    GPVisitCreator *gc = 
+        (GPVisitCreator*)(global::gpvisittypes->getCreator(gpvisittype));
+    SingleGPVisit gpv = gc->makeVisit(this, global::NOTNOTIFIED, draws);
+    gpv.cause = CauseScreening;
+    global::population->slotRegisterGPVisit(gpv);
+    gpvisits++;
+}
     
 void Person::slotTestedPositive(Type infectiontype) 
 {
@@ -534,6 +566,12 @@ void Person::throwEventVisitGP(bool conditional)
 
 void Person::slotBinChange(Bin from, Bin to)
 {
+    // the aggregated contacts up to now are counted with the old bin, as
+    // their events would have been sampled with it
+    for(PartnershipList::iterator it = partnerships.begin();
+        it != partnerships.end(); it++) {
+        (*it)->internalCountContacts();
+    }
     Ageable::slotBinChange(from, to);
     
     global::statspersonbinchanges++;
@@ -542,7 +580,9 @@ void Person::slotBinChange(Bin from, Bin to)
     
     for(PartnershipList::iterator it = partnerships.begin();
         it != partnerships.end(); it++) {
+        (*it)->internalClearCache();
         (*it)->throwEventHaveSex(true);
+        (*it)->throwEventTransmission();
     }
 }
 
@@ -574,20 +614,25 @@ once");
         rif_error(creator->getCfg(),
 "internal while deregistering partnership: not found in active partnerships");
     partnerships.remove(0);
-    partnershipsold.push_front(ps);
+    partnershipsold.push_back(ps);
     global::population->slotUpdatePSFormation(this);
 }
 
 void Person::internalRemovePartnership(Partnership *ps)
 {
+    // old partnerships are removed in the order they ended, so the one to
+    // remove is usually at the front, where the oldest ones are
     for(PartnershipList::iterator it = partnershipsold.begin();
         it != partnershipsold.end(); it++) {
         if (*it == ps) {
-            *it = 0;
+            if ((unsigned int)(it - partnershipsold.begin()) < 
+                partnershipsexpired) {
+                partnershipsexpired--;
+            }
+            partnershipsold.erase(it);
             break;
         }
     }
-    partnershipsold.remove(0);
     
     for(InfectionList::iterator it = infections.begin();
         it != infections.end(); it++) {
@@ -610,25 +655,15 @@ void Person::internalRemoveInfection(Infection *infection)
     for(InfectionList::iterator it = infectionsold.begin();
         it != infectionsold.end(); it++) {
         if (*it == infection) {
-            *it = 0;
+            if ((unsigned int)(it - infectionsold.begin()) < 
+                infectionsexpired) {
+                infectionsexpired--;
+            }
+            infectionsold.erase(it);
             break;
         }
     }
-    infectionsold.remove(0);
-    
-    for(InfectionList::iterator it = infections.begin();
-        it != infections.end(); it++) {
-        if ((*it)->getParent() == infection) {
-            (*it)->clearParent();
-        }
-    }
-    for(InfectionList::iterator it = infectionsold.begin();
-        it != infectionsold.end(); it++) {
-        if ((*it)->getParent() == infection) {
-            (*it)->clearParent();
-        }
-    }
-    
+    // references as parent are cleared by the destructor of the infection
 }
 
 void Person::slotRegisterInfection(Infection *infection)
@@ -652,6 +687,12 @@ void Person::slotRegisterInfection(Infection *infection)
     }
     infections.push_front(infection);
     global::population->slotUpdatePSFormation(this);
+    
+    // contacts in the partnerships can now transmit the infection
+    for (PartnershipList::iterator it = partnerships.begin();
+        it != partnerships.end(); it++) {
+        (*it)->slotUpdateContacts();
+    }
 }
 
 void Person::slotDeregisterInfection(Infection *infection)
@@ -682,7 +723,15 @@ void Person::slotDeregisterInfection(Infection *infection)
             error("internal: infection is already in list 'infectionsold'");  
         }
     }
-    infectionsold.push_front(infection);
+    infectionsold.push_back(infection);
+    global::population->slotRegisterOldInfection(infection);
+    
+    // this person may be infected again by its partners
+    for (PartnershipList::iterator it = partnerships.begin();
+        it != partnerships.end(); it++) {
+        (*it)->internalClearCache();
+        (*it)->throwEventTransmission();
+    }
 }
 
 Infection *Person::getInfection(Type infectiontype) const
@@ -762,8 +811,9 @@ const Partnership * Person::getLastPartnershipWith(const Person *person) const
             Counter puid2 = (*it)->getPerson2()->puid;
             if (uid == puid2) return(*it);
     }
-    for(PartnershipList::const_iterator it = partnershipsold.begin();
-        it != partnershipsold.end(); it++) {
+    // the most recent first
+    for(PartnershipList::const_reverse_iterator it = partnershipsold.rbegin();
+        it != partnershipsold.rend(); it++) {
             if (*it == 0) error("internal error", __LINE__);
             Counter puid1 = (*it)->getPerson1()->puid;
             if (puid == puid1) return(*it);
@@ -781,14 +831,25 @@ void Person::slotNotifyHaveContact(Partnership *ps, bool unprotected)
     
 }
 
+bool Person::hasContactEffects(const Person * /*partner*/) const
+{
+    // with hazard based transmission the contacts do not transmit
+    return(!global::hazardtransmission && !infections.empty());
+}
+
+bool Person::isReferenced() const
+{
+    return(false);
+}
+
 
 string Person::str() const
 {
     ostringstream s;
     s << "Person:"
         << "puid=" << puid
-        << ",motherpuid=" << (mother ? mother->puid : 0)
-        << ",fatherpuid=" << (father ? father->puid : 0)
+        << ",motherpuid=" << motherpuid
+        << ",fatherpuid=" << fatherpuid
         << ",partners=" << partnerscurrent 
         << ",causeCreate=" <<(int)causeCreated
         << "|";
@@ -813,6 +874,7 @@ PersonMale::PersonMale(PersonCreatorMale *pc, CauseCreation why,
     idsubclass = CLASSPERSONMALE;
     
     numchildren = 0;
+    numunborn = 0;
 }
 
 PersonMale::~PersonMale()
@@ -822,6 +884,22 @@ PersonMale::~PersonMale()
 void PersonMale::slotBabyIsBorn(Person *mother)
 {
     numchildren++;
+    numunborn--;
+}
+
+void PersonMale::slotPregnancy(Person * /*mother*/)
+{
+    numunborn++;
+}
+
+void PersonMale::slotAbortion(Person * /*mother*/)
+{
+    numunborn--;
+}
+
+bool PersonMale::isReferenced() const
+{
+    return(numunborn > 0);
 }
 
 Number PersonMale::getNumber(NumberOf what) const
@@ -939,6 +1017,10 @@ void PersonFemale::slotGetPregnant(PersonMale *father)
     pregnant = true;
     numpregnancies++;
     global::statspregnancies++;
+    // the father must stay in memory until the pregnancy ends
+    if (father) {
+        father->slotPregnancy(this);
+    }
     
     Time timeofbirth = global::abstime + getAttribute(
         ((PersonCreatorFemale*)creator)->pregnancyduration, global::abstime
@@ -1015,6 +1097,13 @@ void PersonFemale::slotNotifyHaveContact(Partnership *ps, bool unprotected)
     //happen
 }
 
+bool PersonFemale::hasContactEffects(const Person *partner) const
+{
+    return(Person::hasContactEffects(partner) ||
+        (((PersonCreatorFemale*)creator)->pregnancypercontact &&
+         partner->idsubclass == CLASSPERSONMALE));
+}
+
 
 string PersonFemale::str() const
 {
@@ -24,6 +24,7 @@
 
 #include "typedefs.h"
 #include "object.h"
+#include "slab.h"
 
 
 /**
@@ -189,6 +190,9 @@ protected:
     Attribute probpregnancypercontact;
     /** Attribute that gives a factor to the probabilty of getting pregnant*/
     Attribute probpregnancypercontactfactor;
+    /** Whether 'pregnancy.probabilitypercontact' is configured at all; if not,
+    contacts can not lead to pregnancies */
+    bool pregnancypercontact;
     /** Attribute that gives the duration of a regular pregnancy */
     Attribute pregnancyduration;
     /** Attribute that gives the general rate of getting pregnant if female is
@@ -229,6 +233,19 @@ public:
      * Destructor
      */
     ~Person();
+    /**
+     * Objects of this class are allocated from a SlabAllocator
+     * @see getAllocator()
+     */
+    static void *operator new(std::size_t size)
+        { return(allocator.allocate(size)); };
+    static void operator delete(void *p, std::size_t size)
+        { allocator.deallocate(p, size); };
+    /**
+     * Returns the allocator of this class, eg. for statistics
+     * @return a reference to the SlabAllocator
+     */
+    static SlabAllocator &getAllocator() { return(allocator); };
         
     /**
      * Returns the corresponding PopID object of this Person
@@ -290,11 +307,24 @@ public:
     
     const PartnershipList *getPartnerships() const;
     
+    /**
+     * Returns the ended partnerships in the order they ended, the most recent
+     * last
+     * @return a pointer to a PartnershipList object
+     */
     const PartnershipList *getPartnershipsOld() const;
     
-    const SingleNotificationList *getSingleNotifications() const;
-
-    const SingleGPVisitList *getSingleGPVisits() const;
+    /**
+     * Returns the position in getPartnershipsOld() of the first partnership
+     * that ended at or after a given time; as the list is sorted by the time
+     * of ending, this is a binary search
+     * @param time the time
+     * @return the position, or the size of the list if there is none
+     */
+    unsigned int getPartnershipsOldSince(Time time) const;
+    
+    const NotificationList *getNotifications() const;
+    
     
     void slotVisitGPNotified(Type gpvisittype, Time wait, Notification notif);
     
@@ -363,6 +393,25 @@ public:
      * unprotected
      */
     virtual void slotNotifyHaveContact(Partnership *ps, bool unprotected);
+    /**
+     * Checks whether a contact with a partner can have any effect other than
+     * being counted; the contacts in a partnership where this is false for
+     * both partners need not be simulated individually (see
+     * 'simulation.aggregatecontacts' in the configuration file)
+     * @param partner the partner
+     * @return 'true' if this Person carries an infection, unless
+     * transmissions do not depend on single contacts (see
+     * global::hazardtransmission)
+     */
+    virtual bool hasContactEffects(const Person *partner) const;
+    
+    /**
+     * Returns whether a pending event still points to this Person, so that
+     * it must not be moved to the spill file yet (see
+     * Population::internalRemoveOldPeople())
+     * @return 'false' unless overloaded
+     */
+    virtual bool isReferenced() const;
     
     /**
      * This function is usually called by an infection when in changes its bin
@@ -429,6 +478,15 @@ public:
     virtual void slotVisitGP(
         Type gpvisittype, CauseVisitGP cvgp, Notification notif = global::NOTNOTIFIED
     );
+    /**
+     * This method is called by GPVisitCreator::slotScreening() for the people
+     * that are selected in a screening campaign. It makes the visit in the
+     * same way as slotVisitGP(), but with the uniform numbers drawn in
+     * advance
+     * @param gpvisittype the type of the visit
+     * @param draws the uniform numbers (see GPVisitCreator::makeVisit())
+     */
+    virtual void slotScreened(Type gpvisittype, const double *draws);
     
     /**
      * If GP tests patient positive, this function is called
@@ -450,10 +508,18 @@ public:
  
     /** 
      * This function checks whether the person was already notified under
-     * the notification chain given by "notif"
+     * the notification chain given by "notif"; this is a binary search on
+     * the notifications sorted by nid
      */
     virtual bool isNotifiedAlready(Notification notif);
     
+    /**
+     * Stores the notification chain given by "notif" unless the person was
+     * already notified under it
+     * @return true if the notification was stored
+     */
+    bool registerNotification(Notification notif);
+    
     /** 
      * This function is called from the notifier module whenever this
      * person starts a notification batch
@@ -480,9 +546,9 @@ public:
      */
     virtual void internalRemovePartnership(Partnership *ps);
     /**
-     * This method removes references to the given Infection from this Person.
-     * Such reference can be in the list of infections and old infections,
-     * either as the infection itself or as a parent reference 
+     * This method removes the given Infection from the list of old infections
+     * of this Person; references to it as a parent are cleared by the
+     * destructor of the Infection.
      * Current infections are not checked because they are not
      * supposed to be deleted from the memory if still active.
      * @param infection the pointer to the infection to be removed
@@ -492,6 +558,8 @@ public:
     
     
 protected:
+    /** The allocator for all Person objects */
+    static SlabAllocator allocator;
     /** Stores the PopID obtained thorugh registering and deregistering */
     PopID popid; 
     /** The reason this Person was created */
@@ -503,13 +571,20 @@ protected:
     Number partnerstotal;
     /** The list of current partnerships */
     PartnershipList partnerships;
-    /** The list of past partnerships */
+    /** The list of past partnerships, in the order they ended */
     PartnershipList partnershipsold;
-    
-    /** A pointer to the father or 0 */
-    PersonMale *father;
-    /** A pointer to the mother or 0 */
-    PersonFemale *mother;
+    /** The number of partnerships at the front of 'partnershipsold' that
+    ended at least global::withintimelag ago; as the list is in the order the
+    partnerships ended, the others are those counted 'within' the time lag.
+    This only grows with time and is advanced when the number is needed (see
+    internalExpireWithin()) */
+    mutable unsigned int partnershipsexpired;
+    
+    /** The puid of the father or 0; only the puid is kept, as the father may
+    be removed from the memory before this Person */
+    Counter fatherpuid;
+    /** The puid of the mother or 0 (see 'fatherpuid') */
+    Counter motherpuid;
     
     /** The number of sexual contacts up to now */
     Number contacts;
@@ -548,8 +623,17 @@ protected:
     immune states 'cleared' or 'treated' */
     InfectionList infections;
 
-    /** The list of past infections */
+    /** The list of past infections, in the order they ended */
     InfectionList infectionsold;
+    /** The same as 'partnershipsexpired' for 'infectionsold' */
+    mutable unsigned int infectionsexpired;
+    
+    /**
+     * Advances 'partnershipsexpired' and 'infectionsexpired' to the current
+     * time; since the time only goes forward, this takes constant time on
+     * average
+     */
+    void internalExpireWithin() const;
     
     /** The total number of treatments */
     Number treatments;
@@ -561,15 +645,9 @@ protected:
     Process procVisitGP;
     
     /** A list with previous notifications so that a person is not notified 
-        itself from its partners */
+        itself from its partners; sorted by nid */
     NotificationList notiflist;
     
-    /** A list with previous single notifications with detailed informatio */
-    SingleNotificationList singlenotiflist;
-    
-    /** A list with the detailed information about the GPVisits */
-    SingleGPVisitList singlegpvisitlist;
-    
     /**
      * This method throws the next EventVisitGP event with
      * CauseVisitGP::CauseSymptomsGeneral.
@@ -610,9 +688,27 @@ public:
      * @param mother the calling mother 
      */
     virtual void slotBabyIsBorn(Person *mother);
+    /**
+     * Called by the mother if she gets pregnant from this male
+     * @param mother the calling mother
+     */
+    void slotPregnancy(Person *mother);
+    /**
+     * Called by EventAbortion if the pregnancy from this male ends without
+     * a birth
+     * @param mother the mother
+     */
+    void slotAbortion(Person *mother);
+    /**
+     * True while a pregnancy from this male has not ended, as the
+     * EventBirth or EventAbortion points to him
+     */
+    virtual bool isReferenced() const;
 private:
     /** The number of childern that this male if father to */
     Number numchildren;
+    /** The number of pregnancies from this male that have not ended yet */
+    Number numunborn;
 };
 
 class PersonFemale : public Person {
@@ -652,6 +748,11 @@ public:
      * @see Person::slotNotifyHaveContact()
      */
     virtual void slotNotifyHaveContact(Partnership *ps, bool unprotected);
+    /**
+     * Extends Person::hasContactEffects() by pregnancies, if a probability
+     * of pregnancy per contact is configured and the partner is male
+     */
+    virtual bool hasContactEffects(const Person *partner) const;
     /**
      * This method is called by EventBirth if a mother was specified
      * @param father the father if specified, otherwise 0
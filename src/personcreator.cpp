@@ -230,6 +230,8 @@ PersonCreatorFemale::PersonCreatorFemale(
         "pregnancy", 1
     );
     
+    pregnancypercontact = 
+        rif_exists(getCfg(), "pregnancy.probabilitypercontact");
     probpregnancypercontact = installAttribute(
         global::persontypes, "probability of pregnancy per unprotected contact",
         "probabilitypercontact", "pregnancy", 0
@@ -17,6 +17,8 @@
  *   Free Software Foundation, Inc.,                                       *
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
+#include <algorithm>
+
 #include "population.h"
 #include "person.h"
 #include "event.h"
@@ -25,6 +27,7 @@
 #include "infection.h"
 #include "scheduler.h"
 #include "global.h"
+#include "spill.h"
 
 using namespace std;
 
@@ -33,6 +36,14 @@ Population::Population(ROBJ cfg)
  : Object()
 {
     popsize = rif_asInteger(cfg,0,"size");
+    capacityhint = popsize;
+    if (rif_exists(cfg,"capacity")) {
+        capacityhint = max(popsize, rif_asInteger(cfg,0,"capacity"));
+    }
+    people_v.reserve(capacityhint);
+    people_l.reserve(capacityhint);
+    partnerships_l.reserve(capacityhint);
+    personstate.reserve(capacityhint + 1);
     people_v.resize(popsize);
     for (int i = 0; i < popsize; i++) {
         emptypos_q.push(i);
@@ -60,6 +71,7 @@ Population::Population(ROBJ cfg)
     if (rif_exists(cfg,"atbirth")) {
         atBirthInsert = rif_asString(cfg, 0, "atbirth") == "insert" ? true : false;
     }
+    spill = 0;
     immigration = 0; // by default no immigration
     if (rif_exists(cfg,"immigration")) {
         immigration = createDistribution(rif_lookup(cfg,"immigration"));
@@ -75,33 +87,35 @@ Population::Population(ROBJ cfg)
 
 Population::~Population()
 {
-    for(PeopleList::iterator it = peopledead_l.begin(); 
+    for(PeopleStore::const_iterator it = peopledead_l.begin(); 
         it != peopledead_l.end(); it++) {
         delete *it;
     }
-    for(PeopleList::iterator it = peoplegone_l.begin(); 
+    for(PeopleStore::const_iterator it = peoplegone_l.begin(); 
         it != peoplegone_l.end(); it++) {
         delete *it;
     }
-    for(PeopleList::iterator it = people_l.begin(); 
+    for(PeopleStore::const_iterator it = people_l.begin(); 
         it != people_l.end(); it++) {
         delete *it;
     }
-    for(PartnershipList::iterator it = partnerships_l.begin();
+    for(PartnershipStore::const_iterator it = partnerships_l.begin();
         it != partnerships_l.end(); it++) {
         delete *it;   
     }
-    for(PartnershipList::iterator it = partnershipsended_l.begin();
+    for(PartnershipStore::const_iterator it = partnershipsended_l.begin();
         it != partnershipsended_l.end(); it++) {
         delete *it;   
     }
+    if (spill) delete spill;
     if (immigration) delete immigration;
     if (timeofreplacement) delete timeofreplacement;
 }
 
+// Oldest first, so that people born later can simply be appended
 bool comparePersons(Person *p1, Person*p2)
 {
-    return(p1->getTimeBirth() > p2->getTimeBirth());
+    return(p1->getTimeBirth() < p2->getTimeBirth());
 }
 
 void Population::slotPopulate() 
@@ -162,22 +176,13 @@ PopID Population::slotRegisterPerson(Person *p, CauseCreation why)
 {
     // 'why' not needed for now
     PopID popid;
-    if (emptypos_q.empty()) {
-        // Resize vector by 1
-        int cursize = people_v.size();
-        people_v.resize(cursize+100);
-        for (int i = cursize; i < cursize + 100; i++) {
-            emptypos_q.push(i);
-            people_v[i] = 0;
-        }
-    }
+    if (emptypos_q.empty()) growPeopleVector();
     
     popid.pos_v = emptypos_q.front();
     emptypos_q.pop();
     people_v[popid.pos_v] = p;
         
-    people_l.push_front(p);
-    popid.pos_l = people_l.begin();
+    popid.pos_h = people_l.insert(p);
     
     // We need to do this to make sure that popid is set as early as possible 
     // For infecting a person, popid needs to be set, because an new infection
@@ -185,6 +190,9 @@ PopID Population::slotRegisterPerson(Person *p, CauseCreation why)
     // "throw..." methods
     p->setPopID(popid);
     
+    if (personstate.size() <= p->puid) personstate.resize(p->puid + 1);
+    personstate[p->puid] = PersonActive;
+    
     popsize++;
     
     switch(why) {
@@ -201,38 +209,43 @@ PopID Population::slotRegisterPerson(Person *p, CauseCreation why)
     return(popid);
 }
 
-PopID Population::slotDeregisterPerson(PopID popid, CauseDeletion why)
+void Population::growPeopleVector()
 {
-    // Push into corresponding list of non-active people
-    switch(why) {
-        case CauseDeath : {
-            peopledead_l.push_front(people_v[popid.pos_v]);
-            global::statsdeaths++;
-            break;
-        }
-        case CauseEmigration: {
-            peoplegone_l.push_front(people_v[popid.pos_v]);    
-            global::statsemigrations++;
-            break;
-        }
-        default:
-            error("unknown CauseDeletion");
+    // Grow by half of the current size, so that a growing population causes
+    // only linear copying in total; at most a third of the slots are empty
+    // afterwards, which keeps the rejection in getRandomPerson() cheap
+    int cursize = people_v.size();
+    int newsize = max(cursize + cursize/2, cursize + 100);
+    people_v.resize(newsize);
+    for (int i = cursize; i < newsize; i++) {
+        emptypos_q.push(i);
+        people_v[i] = 0;
     }
+}
+
+PopID Population::slotDeregisterPerson(PopID popid, CauseDeletion why)
+{
+    Person *p = people_v[popid.pos_v];
     
     // Delete in people list and vector
-    people_l.erase(popid.pos_l);
+    people_l.erase(popid.pos_h);
     people_v[popid.pos_v] = 0;   
     
-    // Construct new popid
+    // Construct new popid, pointing into the corresponding list of non-active
+    // people
     emptypos_q.push(popid.pos_v);  // Make slot in people_v available
     popid.pos_v = INTNA;
     switch(why) {
         case CauseDeath : {
-            popid.pos_l = peopledead_l.begin();
+            popid.pos_h = peopledead_l.insert(p);
+            personstate[p->puid] = PersonDead;
+            global::statsdeaths++;
             break;
         }
         case CauseEmigration: {
-            popid.pos_l = peoplegone_l.begin();
+            popid.pos_h = peoplegone_l.insert(p);
+            personstate[p->puid] = PersonGone;
+            global::statsemigrations++;
             break;
         }
         default:
@@ -273,18 +286,17 @@ void Population::slotDeregisterFromPSFormation(Person *person)
 PartnershipID Population::slotRegisterPartnership(Partnership *ps)
 {
     PartnershipID psid;
-    partnerships_l.push_front(ps);
-    psid.pos_l = partnerships_l.begin();
+    psid.pos_h = partnerships_l.insert(ps);
     global::statspscreated++;
     return(psid);
 }
 
 PartnershipID Population::slotDeregisterPartnership(PartnershipID psid)
 {
-    partnershipsended_l.push_front(getPartnership(psid));
-    partnerships_l.erase(psid.pos_l);
+    Partnership *ps = getPartnership(psid);
+    partnerships_l.erase(psid.pos_h);
 
-    psid.pos_l = partnershipsended_l.begin();
+    psid.pos_h = partnershipsended_l.insert(ps);
     global::statspsended++;
     return(psid);
 }
@@ -302,48 +314,105 @@ Person *Population::getRandomPerson(const Distribution *uniform) const
 
 void Population::internalRemoveOldPartnerships()
 {    
-    for (PartnershipList::iterator it = partnershipsended_l.begin();
-        it != partnershipsended_l.end(); it++) {
-           if ((*it)->getTimeDeath() < global::abstime -
-global::removepsolderthan) {
-                Partnership *ps = *it;
-//                ps->print();
-                ps->getPerson1()->internalRemovePartnership(ps);
-                ps->getPerson2()->internalRemovePartnership(ps);
-                delete ps;
-                *it = 0;
-           }
+    // partnerships are appended to the list when they end, so the list is 
+    // ordered by time of death and the expired ones are at the front
+    while (!partnershipsended_l.empty() && 
+        partnershipsended_l.front()->getTimeDeath() < 
+            global::abstime - global::removepsolderthan) {
+        Partnership *ps = partnershipsended_l.front();
+//        ps->print();
+        ps->getPerson1()->internalRemovePartnership(ps);
+        ps->getPerson2()->internalRemovePartnership(ps);
+        delete ps;
+        partnershipsended_l.pop_front();
     }
-    partnershipsended_l.remove(0);
+}
+
+void Population::slotRegisterOldInfection(Infection *infection)
+{
+    infectionsold_q.push_back(
+        make_pair(infection->getHost()->puid, infection));
+}
+
+void Population::slotRegisterTransmission(const Infection *infection)
+{
+    TransmissionRecord r;
+    r.time = infection->getTimeBirth();
+    r.infuid = infection->infuid;
+    r.parentinfuid = infection->getParentInfuid();
+    r.strainid = infection->getStrainID();
+    r.hostpuid = infection->getHost()->puid;
+    r.psuid = infection->getPartnership() ? 
+        infection->getPartnership()->psuid : 0;
+    r.type = infection->getType();
+    transmissions.push_back(r);
 }
 
 void Population::internalRemoveOldInfections()
 {
-    PeopleList *people;
-    InfectionList dl;
-    
-    people = (PeopleList *)(global::population->getActivePeopleList());
+    // infections enter the queue when they end, so the expired ones are at the
+    // front
+    while (!infectionsold_q.empty()) {
+        // only infections of the active population are removed, the ones of 
+        // dead people stay with them; their hosts may not be in memory
+        // any more, so the infection is not looked at
+        if (getPersonState(infectionsold_q.front().first) != PersonActive) {
+            infectionsold_q.pop_front();
+            continue;
+        }
+        Infection *infection = infectionsold_q.front().second;
+        if (infection->getTimeDeath() >= 
+            global::abstime - global::removeinfolderthan) break;
+        infectionsold_q.pop_front();
+        infection->getHost()->internalRemoveInfection(infection);
+        delete infection;
+    }
+}
+
+void Population::internalCompactMemory()
+{
+    Person::getAllocator().compact();
+    Partnership::getAllocator().compact();
+    Infection::getAllocator().compact();
+}
+
+void Population::internalCountContacts()
+{
+    if (!global::aggregatecontacts) return;
+    for (PartnershipStore::const_iterator it = partnerships_l.begin();
+        it != partnerships_l.end(); it++) {
+        (*it)->internalCountContacts();
+    }
+}
+
+void Population::internalRemoveOldPeople()
+{
+    Time limit = global::abstime - global::removepeopleolderthan;
     
-    for (PeopleList::iterator it = people->begin();
-        it != people->end(); it++) {
-            const InfectionList *dltmp = (*it)->getInfectionsOld();
-            for (InfectionList::const_iterator itd = dltmp->begin();
-                itd != dltmp->end(); itd++) {
-                    if ((*itd)->getTimeDeath() < global::abstime -
-global::removeinfolderthan) {
-                        dl.push_front(*itd);
-                    }
-            }
+    // the lists are ordered by time of death; people that still have
+    // partnerships in the memory are kept, as the partnership refers to them,
+    // and so are fathers of children that are not born yet
+    vector<Person*> old[2];
+    PeopleStore *stores[2] = { &peopledead_l, &peoplegone_l };
+    for (int s = 0; s < 2; s++) {
+        for (PeopleStore::const_iterator it = stores[s]->begin();
+            it != stores[s]->end() && (*it)->getTimeDeath() < limit; it++) {
+            if ((*it)->getPartnershipsOld()->empty() && 
+                !(*it)->isReferenced()) old[s].push_back(*it);
+        }
     }
+    if (old[0].empty() && old[1].empty()) return;
     
-    for (InfectionList::iterator itd = dl.begin();
-        itd != dl.end(); itd++) {
-        for (PeopleList::iterator it = people->begin();
-            it != people->end(); it++) {
-                (*it)->internalRemoveInfection(*itd);
-            }
-        delete *itd;
+    // the entries of their old infections in infectionsold_q are dropped by
+    // internalRemoveOldInfections() by the state of the host alone
+    
+    if (!spill) spill = new SpillFile(global::spillfilename);
+    for (int s = 0; s < 2; s++) {
+        for (unsigned int i = 0; i < old[s].size(); i++) {
+            Person *p = old[s][i];
+            spill->write(p, s == 1);
+            stores[s]->erase(p->getPopID().pos_h);
+            delete p;
+        }
     }
- 
 }
-
@@ -21,8 +21,11 @@
 #define POPULATION_H
 
 #include <queue>
+#include <deque>
+#include <utility>
 
 #include "object.h"
+#include "recordlog.h"
 
 class Population : public Object
 {
@@ -30,15 +33,27 @@ public:
     Population(ROBJ cfg);
     ~Population();
 
-    const PeopleList* getActivePeopleList() const
+    const PeopleStore* getActivePeopleList() const
         { return(&people_l); };
-    const PeopleList* getDeadPeopleList() const
+    const PeopleStore* getDeadPeopleList() const
         { return(&peopledead_l); };
+    const PeopleStore* getGonePeopleList() const
+        { return(&peoplegone_l); };
+    // The dead people that were moved out of the memory, or 0 if none
+    const SpillFile* getSpillFile() const
+        { return(spill); };
     int getActivePopulationSize() const
         { return(popsize); };
-    const PartnershipList* getActivePartnershipList() const
+    // Number of slots for active people; tables indexed by PopID.pos_v 
+    // (eg. in PSFormerIndivSearch) should be at least this large
+    int getCapacity() const
+        { return(people_v.size()); };
+    // The number of active people that storage is reserved for initially
+    int getCapacityHint() const
+        { return(capacityhint); };
+    const PartnershipStore* getActivePartnershipList() const
         { return(&partnerships_l); };
-    const PartnershipList* getEndedPartnershipList() const
+    const PartnershipStore* getEndedPartnershipList() const
         { return(&partnershipsended_l); };
 
     Person * getRandomPerson(const Distribution *uniform) const;
@@ -50,12 +65,14 @@ public:
     
     PopID slotRegisterPerson(Person *p, CauseCreation why);
     PopID slotDeregisterPerson(PopID popid, CauseDeletion why);
-    Person *getPerson(PopID popid) const { return (*(popid.pos_l)); };
+    // Only for active people, the others have pos_v == INTNA
+    Person *getPerson(PopID popid) const { return (people_l.get(popid.pos_h)); };
    
     PartnershipID slotRegisterPartnership(Partnership *ps);
     PartnershipID slotDeregisterPartnership(PartnershipID psid);
+    // Only for active partnerships
     Partnership *getPartnership(PartnershipID psid) const { return
-(*(psid.pos_l)); };
+(partnerships_l.get(psid.pos_h)); };
     
     void slotRegisterForPSFormation(Person *person); // At birth register for
                                             //partnership formation
@@ -64,8 +81,42 @@ public:
     void slotDeregisterFromPSFormation(Person *person); // At death or
                                                     //emigration deregister   
     
+    // An infection calls this when it is moved to the list of old infections
+    // of its host
+    void slotRegisterOldInfection(Infection *infection);
+    // A new infection calls this to be added to the log of transmissions
+    void slotRegisterTransmission(const Infection *infection);
+    // All infections in the order they were created (and thus by infuid);
+    // the log is never shortened, so the full transmission forest can be
+    // rebuilt even if old infections were removed from the memory
+    const std::vector<TransmissionRecord>* getTransmissions() const
+        { return(&transmissions); };
+    // Notifications and GP visits are logged here rather than with the
+    // people, in the order they happened; the state of the sending or
+    // visiting person tells apart the records of active, dead and gone people
+    void slotRegisterNotification(const SingleNotification &sn)
+        { notificationlog.push_back(sn); };
+    void slotRegisterGPVisit(const SingleGPVisit &gpv)
+        { gpvisitlog.push_back(gpv); };
+    const NotificationLog* getNotificationLog() const
+        { return(&notificationlog); };
+    const GPVisitLog* getGPVisitLog() const
+        { return(&gpvisitlog); };
+    enum PersonState { PersonActive = 0, PersonDead, PersonGone };
+    PersonState getPersonState(Counter puid) const
+        { return((PersonState)personstate[puid]); };
+    
     void internalRemoveOldPartnerships();
     void internalRemoveOldInfections();
+    // Moves the people that died (or emigrated) longer than
+    // global::removepeopleolderthan ago to the spill file
+    void internalRemoveOldPeople();
+    // Gives the unused memory of the Person, Partnership and Infection 
+    // allocators back to the system
+    void internalCompactMemory();
+    // Counts the contacts up to now in the partnerships whose contacts are
+    // not simulated individually (see Partnership::internalCountContacts())
+    void internalCountContacts();
 
 private:
     // Storing the people
@@ -73,15 +124,33 @@ private:
 
     PeopleVector people_v; 
     std::queue<int> emptypos_q;
+    int capacityhint;
+    void growPeopleVector();
+    
+    PeopleStore people_l;
+    
+    PeopleStore peopledead_l;
+    PeopleStore peoplegone_l;
+    // Dead and gone people removed from the lists above; created on first use
+    SpillFile *spill;
     
-    PeopleList people_l;
+    PartnershipStore partnerships_l;
+    // Ended partnerships in the order they ended, the oldest first; this order
+    // is used by internalRemoveOldPartnerships()
+    PartnershipStore partnershipsended_l;
     
-    PeopleList peopledead_l;
-    PeopleList peoplegone_l;
+    // Old infections in the order they ended (ie. by time of death); used by
+    // internalRemoveOldInfections() to find the expired ones without
+    // searching the population. The puid of the host is stored along, so
+    // that the entries of hosts that are no longer active (and may have been
+    // moved to the spill file) are dropped without looking at the infection
+    std::deque<std::pair<Counter, Infection*> > infectionsold_q;
     
-    // Array 
-    PartnershipList partnerships_l;
-    PartnershipList partnershipsended_l;
+    std::vector<TransmissionRecord> transmissions;
+    NotificationLog notificationlog;
+    GPVisitLog gpvisitlog;
+    // PersonState of every person ever registered, indexed by puid
+    std::vector<char> personstate;
     
     // Flags
     bool atDeathReplace;
@@ -33,7 +33,9 @@ Process::Process()
 
 Process::~Process() 
 {
-    if (nextevent) {
+    // when the model is removed, the scheduler (and its events) may be gone
+    // already
+    if (nextevent && global::scheduler) {
         global::scheduler->remove(nextevent);
     }
 }
@@ -18,6 +18,8 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <algorithm>
+
 #include "partnership.h"
 
 #include "global.h"
@@ -73,12 +75,10 @@ name, ROBJ cfg)
     
     idsubclass = CLASSPARTNERSHIPFORMERINDIVIDUAL;
    
-    // to start with, set vector to population size 
-    procPSForm.resize(global::population->getActivePopulationSize());
-    
-    for(unsigned int i = 0; i < procPSForm.size(); i++) {
-        procPSForm[i] = 0;
-    }
+    // to start with, set vector to the number of slots of the population
+    procPSFormActive.reserve(global::population->getCapacityHint());
+    procPSForm.resize(global::population->getCapacity());
+    procPSFormActive.resize(global::population->getCapacity(), 0);
     
     typeisactive = 0;
     agediffmean = 0;
@@ -168,19 +168,20 @@ void PSFormerIndivSearch::slotPersonRegister(Person *person)
 valid popid");
     }
     if ((unsigned int)pos_v >= procPSForm.size()) {
-        int size = procPSForm.size();
-        procPSForm.resize(pos_v+100);
-        for (unsigned int i = size; i < procPSForm.size(); i++) 
-            procPSForm[i] = 0;
+        // follow the (geometric) growth of the population's slots
+        int size = max(pos_v+1, global::population->getCapacity());
+        procPSForm.resize(size);
+        procPSFormActive.resize(size, 0);
     }
     
     if (typeisactive[person->getType()]) {
-        if (procPSForm[pos_v]) {
+        if (procPSFormActive[pos_v]) {
           error(
 "internal: trying to assign new partnership formation process, but possion is\
 occupied already");
         }
-        procPSForm[pos_v] = new Process();
+        procPSForm[pos_v] = Process();
+        procPSFormActive[pos_v] = 1;
         throwEventPSInitiate(person);    
     }
 }
@@ -188,14 +189,15 @@ occupied already");
 void PSFormerIndivSearch::slotPersonDeregister(Person *person)
 {
     if (typeisactive[person->getType()]) {
-      if (procPSForm[person->getPopID().pos_v]) {
-          delete procPSForm[person->getPopID().pos_v];
+      int pos_v = person->getPopID().pos_v;
+      if (procPSFormActive[pos_v]) {
+          procPSForm[pos_v].clear();
       } else {
             error(
 "internal: trying to remove partnership formation process, but there is no\
 active process present at this position");
       }
-      procPSForm[person->getPopID().pos_v] = 0;
+      procPSFormActive[pos_v] = 0;
     }
 }
 
@@ -208,7 +210,7 @@ void PSFormerIndivSearch::slotPersonUpdate(Person *person)
 void PSFormerIndivSearch::throwEventPSInitiate(Person *person)
 {
     int pos_v = person->getPopID().pos_v;
-    if (!procPSForm[pos_v]) {
+    if (!procPSFormActive[pos_v]) {
         error("internal: no Process object present", __LINE__);
     }
     if (!person->isAlive()) {
@@ -221,11 +223,11 @@ void PSFormerIndivSearch::throwEventPSInitiate(Person *person)
     double wait = person->getAttributeFac(seek, global::abstime, wf);
     double time = global::abstime + wait;
     if (time < person->getTimeDeath()) {
-        procPSForm[pos_v]->replace(new EventPSInitiate(
+        procPSForm[pos_v].replace(new EventPSInitiate(
             global::abstime+wait, this, person
         ));
     } else {
-        procPSForm[pos_v]->clear();
+        procPSForm[pos_v].clear();
     }
 }
 
@@ -89,6 +89,8 @@ namespace ran {
 
 static unsigned int rangen_rands[RANCORES][128];
 static unsigned int rangen_p[RANCORES];
+static unsigned long long int rangen_rands64[RANCORES][128];
+static unsigned int rangen_p64[RANCORES];
 
 #ifdef _OPENMP
 static omp_lock_t omplocks[RANCORES];
@@ -109,6 +111,18 @@ void rand_dia_init (unsigned int randcore, unsigned int seed)
      rangen_rands[randcore][i] |= 1;
 #endif
    }
+   /* the 64-bit buffer: all values odd (no implicid bits) */
+   rangen_p64[randcore] = 0;
+   rangen_rands64[randcore][0] = 
+       (((unsigned long long int)seed) << 1) | 1;
+   for (i=1;i<R;i++)
+     rangen_rands64[randcore][i] = 
+         6364136223846793005ULL * rangen_rands64[randcore][i-1] 
+         + 1442695040888963407ULL;
+   for (i=0;i<R;i++) {
+     rangen_rands64[randcore][i] += rangen_rands64[randcore][i]>>32;
+     rangen_rands64[randcore][i] |= 1;
+   }
 #ifdef _OPENMP
     omp_init_lock(omplocks+randcore);
 #endif   
@@ -155,6 +169,22 @@ unsigned int rand_dia (unsigned int randcore)
    return b0 + (b0>>16);    /* low bit improvement */
 }
 
+unsigned long long int rand_dia64 (unsigned int randcore)
+{
+#ifdef _OPENMP
+    omp_set_lock(omplocks+randcore);
+#endif   
+   /* fib(n) = fib(n-R) * fib(n-S) mod 2**64; with all fib() odd. */
+   unsigned int pos = --rangen_p64[randcore];
+   unsigned long long int br = rangen_rands64[randcore][(pos+R) & MASK];
+   unsigned long long int bs = rangen_rands64[randcore][(pos+S) & MASK];
+   unsigned long long int b0 = br*bs;
+   rangen_rands64[randcore][pos & MASK] = b0;
+#ifdef _OPENMP
+    omp_unset_lock(omplocks+randcore);
+#endif   
+   return b0 + (b0>>32);    /* low bit improvement */
+}
 
 void sran()
 {
@@ -171,24 +201,111 @@ void sran(unsigned int init)
     }
 }
 
+/* layout of the state buffer: a header (version, RANCORES, R) followed for
+   each core by the position and the buffer of the 32-bit generator, then the
+   position and the buffer of the 64-bit generator (low word first) */
+#define STATEVERSION 1
+#define STATEHEADER 3
+#define STATECORE (1 + 128 + 1 + 2*128)
+
+unsigned int getStateSize()
+{
+    return STATEHEADER + RANCORES*STATECORE;
+}
+
+void getState(unsigned int *buf)
+{
+    *buf++ = STATEVERSION;
+    *buf++ = RANCORES;
+    *buf++ = R;
+    for (int c = 0; c < RANCORES; c++) {
+        *buf++ = rangen_p[c];
+        for (int i = 0; i < 128; i++) *buf++ = rangen_rands[c][i];
+        *buf++ = rangen_p64[c];
+        for (int i = 0; i < 128; i++) {
+            *buf++ = (unsigned int)(rangen_rands64[c][i]);
+            *buf++ = (unsigned int)(rangen_rands64[c][i]>>32);
+        }
+    }
+}
+
+bool setState(const unsigned int *buf)
+{
+    if (buf[0] != STATEVERSION || buf[1] != RANCORES || buf[2] != R) 
+        return false;
+    buf += STATEHEADER;
+    for (int c = 0; c < RANCORES; c++) {
+        rangen_p[c] = *buf++;
+        for (int i = 0; i < 128; i++) rangen_rands[c][i] = *buf++;
+        rangen_p64[c] = *buf++;
+        for (int i = 0; i < 128; i++) {
+            unsigned long long int lo = *buf++;
+            unsigned long long int hi = *buf++;
+            rangen_rands64[c][i] = lo | (hi << 32);
+        }
+    }
+    return true;
+}
+
 unsigned int ran(unsigned int randcore, unsigned int max)
 {
+#if RANGEN64==1
+    /* Lemire's method: take the high word of a 32x32 bit product and reject
+       the few values that would make the result biased; the modulo is only
+       needed when the low word is smaller than 'max' */
+    unsigned long long int m = 
+        (rand_dia64(randcore)>>32) * (unsigned long long int)max;
+    unsigned int l = (unsigned int)m;
+    if (l < max) {
+        unsigned int t = (0u - max) % max;
+        while (l < t) {
+            m = (rand_dia64(randcore)>>32) * (unsigned long long int)max;
+            l = (unsigned int)m;
+        }
+    }
+    return (unsigned int)(m >> 32);
+#else
     return (unsigned int)((((long long unsigned int)rand_dia(randcore))
        *(long long unsigned int)max) >> 32);
+#endif
+}
+
+/* the upper 52 bits of 'x', shifted to the midpoint of their interval, ie.
+   strictly between 0 and 1; with 52 bits the half step is still exact in a
+   double, with 53 bits the largest values would round to 1 */
+static inline double unitOpen(unsigned long long int x) {
+    return ((double)(x>>12) + 0.5) * (1.0/4503599627370496.0);
 }
 
 double dran(unsigned int randcore) {
+#if RANGEN64==1
+    double u = unitOpen(rand_dia64(randcore));
+#else
     double u = (double)(rand_dia(randcore));
     u = u /4294967296.0;    
+#endif
     return u;
 }
 
 double dran(unsigned int randcore, double min, double max) {
+#if RANGEN64==1
+    return dran(randcore) * (max - min) + min;
+#else
     double u = (double)(rand_dia(randcore));
     u = u * (max - min) /4294967296.0 + min;    
     return u;
+#endif
 }
 
+double dran(unsigned long long int key, unsigned long long int counter) {
+    /* the finaliser of splitmix64 applied to the counter-th element of the
+       Weyl sequence starting at the key */
+    unsigned long long int z = key + (counter + 1)*0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+    return unitOpen(z);
+}
 
 }
 
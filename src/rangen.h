@@ -72,6 +72,14 @@ Ex31):
  */ 
 #define RANCORES 100
 
+/**
+ * If set to 1, ran() and dran() are based on rand_dia64(), the 64-bit version
+ * of the generator; doubles then have 52 bits of resolution (and are never
+ * exactly 0 or 1, so that -log(dran()) is always finite) and bounded integers
+ * are unbiased; set to 0 to get the original 32-bit streams back
+ */
+#define RANGEN64 1
+
 namespace ran {
 
 /**
@@ -87,6 +95,28 @@ void sran();
  */
 void sran(unsigned int init);
 
+/**
+ * Returns the number of 32-bit words needed to store the state of all random
+ * number generators 
+ * @return the size of the buffer needed by getState() and setState()
+ */
+unsigned int getStateSize();
+/**
+ * Copies the complete state of all random number generators (all cores, 32-
+ * and 64-bit) into a buffer, so that it can later be restored by setState()
+ * @param buf a buffer of at least getStateSize() words
+ */
+void getState(unsigned int *buf);
+/**
+ * Restores the state of all random number generators from a buffer filled by
+ * getState(); after this call the generators produce exactly the same numbers
+ * as they did after the call to getState()
+ * @param buf a buffer of getStateSize() words
+ * @return false if the buffer does not come from a compatible generator (in
+ * which case the state is left untouched), true otherwise
+ */
+bool setState(const unsigned int *buf);
+
 /**
  * Return an unsigned integer between 0 and 'max' (not including 'max')
  * @param randcore the core to be used (0 to RANCORES-1)
@@ -100,6 +130,13 @@ unsigned int ran(unsigned int randcore, unsigned int max);
  * @return one random number
  */
 unsigned int rand_dia(unsigned int randcore);
+/**
+ * Return an unsigned integer between 0 and 2^64-1 (including this value); the
+ * same recurrence as rand_dia() but on 64-bit words, with its own state
+ * @param randcore the core to be used (0 to RANCORES-1)
+ * @return one random number
+ */
+unsigned long long int rand_dia64(unsigned int randcore);
 
 /**
  * Return a random real number between 'min' and 'max'
@@ -116,4 +153,16 @@ double dran(unsigned int randcore, double min, double max);
  */
 double dran(unsigned int randcore);
 
+/**
+ * Return a random real number between 0 and 1 from a counter-based stream:
+ * the number only depends on the key and the counter, so that the numbers of
+ * a stream can be drawn in any order and by several threads at the same
+ * time without touching the state of the cores above. Use a key drawn from
+ * one of the cores to get a new stream for every purpose
+ * @param key the key of the stream
+ * @param counter the position in the stream
+ * @return one random number
+ */
+double dran(unsigned long long int key, unsigned long long int counter);
+
 }
@@ -0,0 +1,106 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Adrian Roellin   *
+ *   roellin@ispm.unibe.ch   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef RECORDLOG_H
+#define RECORDLOG_H
+
+#include <vector>
+
+#include "typedefs.h"
+
+// Append-only log of all notifications of the simulation, in the order they
+// were made, with one vector per field of SingleNotification; the counters
+// are stored as int, as they are exported, so that a column can be copied to
+// R in one go
+class NotificationLog
+{
+public:
+    void push_back(const SingleNotification &sn) {
+        ntype.push_back(sn.ntype);
+        nid.push_back(sn.nid);
+        linknumber.push_back(sn.linknumber);
+        time.push_back(sn.time);
+        puid1.push_back(sn.puid1);
+        ptype1.push_back(sn.ptype1);
+        pbin1.push_back(sn.pbin1);
+        puid2.push_back(sn.puid2);
+        ptype2.push_back(sn.ptype2);
+        pbin2.push_back(sn.pbin2);
+        psuid.push_back(sn.psuid);
+        pstype.push_back(sn.pstype);
+        psbin.push_back(sn.psbin);
+    };
+    unsigned int size() const { return(time.size()); };
+    // the memory used by the columns
+    double bytes() const
+        { return((double)time.capacity()*(sizeof(double) + 12*sizeof(int))); };
+
+    std::vector<int> ntype;
+    std::vector<int> nid;
+    std::vector<int> linknumber;
+    std::vector<double> time;
+    std::vector<int> puid1; // the sender
+    std::vector<int> ptype1;
+    std::vector<int> pbin1;
+    std::vector<int> puid2; // the receiver
+    std::vector<int> ptype2;
+    std::vector<int> pbin2;
+    std::vector<int> psuid;
+    std::vector<int> pstype;
+    std::vector<int> psbin;
+};
+
+// The same for the GP visits (see SingleGPVisit)
+class GPVisitLog
+{
+public:
+    void push_back(const SingleGPVisit &gpv) {
+        gptype.push_back(gpv.gptype);
+        nid.push_back(gpv.nid);
+        linknumber.push_back(gpv.linknumber);
+        time.push_back(gpv.time);
+        ntype.push_back(gpv.ntype);
+        cause.push_back(gpv.cause);
+        dirtreated.push_back(gpv.dirtreated);
+        tested.push_back(gpv.tested);
+        posresults.push_back(gpv.posresults);
+        puid.push_back(gpv.puid);
+        ptype.push_back(gpv.ptype);
+        pbin.push_back(gpv.pbin);
+    };
+    unsigned int size() const { return(time.size()); };
+    // the memory used by the columns
+    double bytes() const
+        { return((double)time.capacity()*(sizeof(double) + 11*sizeof(int))); };
+
+    std::vector<int> gptype;
+    std::vector<int> nid;
+    std::vector<int> linknumber;
+    std::vector<double> time;
+    std::vector<int> ntype;
+    std::vector<int> cause;
+    std::vector<int> dirtreated;
+    std::vector<int> tested;
+    std::vector<int> posresults;
+    std::vector<int> puid;
+    std::vector<int> ptype;
+    std::vector<int> pbin;
+};
+
+#endif
@@ -0,0 +1,142 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Adrian Roellin   *
+ *   roellin@ispm.unibe.ch   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include <new>
+#include <algorithm>
+
+#include "slab.h"
+
+using namespace std;
+
+SlabAllocator::SlabAllocator(unsigned int _objectsperslab)
+{
+    objectsperslab = _objectsperslab;
+    for (int sc = 0; sc < SIZECLASSES; sc++) freelist[sc] = 0;
+    inuse = 0;
+    allocations = 0;
+    bytesinuse = 0;
+    bytesreserved = 0;
+}
+
+SlabAllocator::~SlabAllocator()
+{
+    for (int sc = 0; sc < SIZECLASSES; sc++) {
+        for (unsigned int i = 0; i < slabs[sc].size(); i++) {
+            ::operator delete(slabs[sc][i]);
+        }
+    }
+}
+
+void SlabAllocator::newSlab(int sc)
+{
+    size_t size = (sc+1)*GRANULARITY;
+    char *slab = (char*)::operator new(size*objectsperslab);
+    slabs[sc].push_back(slab);
+    bytesreserved += size*objectsperslab;
+    // link the objects in address order
+    for (unsigned int i = objectsperslab; i > 0; i--) {
+        FreeNode *node = (FreeNode*)(slab + (i-1)*size);
+        node->next = freelist[sc];
+        freelist[sc] = node;
+    }
+}
+
+void *SlabAllocator::allocate(size_t size)
+{
+    allocations++;
+    inuse++;
+    bytesinuse += size;
+    int sc = size ? (size-1)/GRANULARITY : 0;
+    if (sc >= SIZECLASSES) {
+        bytesreserved += size;
+        return(::operator new(size));
+    }
+    if (!freelist[sc]) newSlab(sc);
+    FreeNode *node = freelist[sc];
+    freelist[sc] = node->next;
+    return(node);
+}
+
+void SlabAllocator::deallocate(void *p, size_t size)
+{
+    if (!p) return;
+    inuse--;
+    bytesinuse -= size;
+    int sc = size ? (size-1)/GRANULARITY : 0;
+    if (sc >= SIZECLASSES) {
+        bytesreserved -= size;
+        ::operator delete(p);
+        return;
+    }
+    FreeNode *node = (FreeNode*)p;
+    node->next = freelist[sc];
+    freelist[sc] = node;
+}
+
+void SlabAllocator::compact()
+{
+    for (int sc = 0; sc < SIZECLASSES; sc++) {
+        if (slabs[sc].empty()) continue;
+        size_t slabsize = (sc+1)*GRANULARITY*objectsperslab;
+        // collect the free objects and sort them by address
+        vector<char*> free;
+        for (FreeNode *node = freelist[sc]; node; node = node->next) {
+            free.push_back((char*)node);
+        }
+        sort(free.begin(), free.end());
+        sort(slabs[sc].begin(), slabs[sc].end());
+        // count the free objects in each slab
+        vector<unsigned int> nfree(slabs[sc].size(), 0);
+        for (unsigned int i = 0; i < free.size(); i++) {
+            unsigned int s = upper_bound(slabs[sc].begin(), slabs[sc].end(),
+                free[i]) - slabs[sc].begin() - 1;
+            nfree[s]++;
+        }
+        // give back the empty slabs and keep the others in address order
+        vector<char*> kept;
+        for (unsigned int s = 0; s < slabs[sc].size(); s++) {
+            if (nfree[s] == objectsperslab) {
+                ::operator delete(slabs[sc][s]);
+                bytesreserved -= slabsize;
+            } else {
+                kept.push_back(slabs[sc][s]);
+            }
+        }
+        slabs[sc].swap(kept);
+        // rebuild the free list in address order
+        freelist[sc] = 0;
+        for (unsigned int i = free.size(); i > 0; i--) {
+            char *p = free[i-1];
+            unsigned int s = upper_bound(slabs[sc].begin(), slabs[sc].end(),
+                p) - slabs[sc].begin();
+            // skip the objects of the slabs given back
+            if (s == 0 || p >= slabs[sc][s-1] + slabsize) continue;
+            FreeNode *node = (FreeNode*)p;
+            node->next = freelist[sc];
+            freelist[sc] = node;
+        }
+    }
+}
+
+Counter SlabAllocator::getSlabs() const
+{
+    Counter n = 0;
+    for (int sc = 0; sc < SIZECLASSES; sc++) n += slabs[sc].size();
+    return(n);
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Adrian Roellin   *
+ *   roellin@ispm.unibe.ch   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <cstddef>
+#include <vector>
+
+#include "typedefs.h"
+
+/**
+ * A simple allocator for objects that are created and deleted in large
+ * numbers (Person, Partnership, Infection). Memory is taken from the system in
+ * slabs that hold many objects; freed objects go to a free list and are reused
+ * by the next allocation of the same size class. The size classes are
+ * multiples of 16 bytes and each object goes to the smallest one it fits in,
+ * so objects of different classes (eg. PersonMale and PersonFemale) share a
+ * size class if their sizes round up to the same value; sizes larger than the
+ * biggest size class are passed to the global operator new.
+ */
+class SlabAllocator
+{
+public:
+    /**
+     * Constructor
+     * @param objectsperslab the number of objects in one slab
+     */
+    SlabAllocator(unsigned int objectsperslab = 256);
+    /**
+     * Destructor; gives all slabs back to the system, so all objects must have
+     * been deleted before
+     */
+    ~SlabAllocator();
+    /**
+     * Returns memory for one object of the given size
+     * @param size the size in bytes, as passed to operator new
+     * @return a pointer to the memory
+     */
+    void *allocate(std::size_t size);
+    /**
+     * Gives the memory of an object back
+     * @param p the pointer returned by allocate()
+     * @param size the same size as passed to allocate()
+     */
+    void deallocate(void *p, std::size_t size);
+    /**
+     * Gives the slabs that contain no object back to the system and orders the
+     * free lists by address, so that new objects fill the remaining slabs
+     * from the start and the living objects become more contiguous over time
+     */
+    void compact();
+    /** @return the number of objects currently allocated */
+    Counter getObjectsInUse() const { return(inuse); };
+    /** @return the total number of allocations so far */
+    Counter getAllocations() const { return(allocations); };
+    /** @return the bytes used by the objects currently allocated */
+    Counter getBytesInUse() const { return(bytesinuse); };
+    /** @return the bytes taken from the system, including the free objects */
+    Counter getBytesReserved() const { return(bytesreserved); };
+    /** @return the number of slabs currently held */
+    Counter getSlabs() const;
+
+private:
+    /** a free object is used to link the free list */
+    struct FreeNode { FreeNode *next; };
+    /** the sizes are rounded up to multiples of this */
+    static const std::size_t GRANULARITY = 16;
+    /** the number of size classes; bigger objects are not pooled */
+    static const int SIZECLASSES = 64;
+
+    /** the free list of each size class */
+    FreeNode *freelist[SIZECLASSES];
+    /** the slabs of each size class */
+    std::vector<char*> slabs[SIZECLASSES];
+    unsigned int objectsperslab;
+    Counter inuse;
+    Counter allocations;
+    Counter bytesinuse;
+    Counter bytesreserved;
+
+    void newSlab(int sc);
+};
+
+#endif
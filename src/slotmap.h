@@ -0,0 +1,195 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Adrian Roellin   *
+ *   roellin@ispm.unibe.ch   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+// A handle into a SlotMap. The slot stays the same for the lifetime of the
+// element, the generation tells apart elements which used the same slot.
+typedef struct {
+    unsigned int slot;
+    unsigned int gen;
+} SlotHandle;
+
+// Storage for pointers with stable handles and dense iteration. The elements
+// are kept in insertion order in one vector; erasing leaves a hole which is
+// skipped when iterating and removed by the next compaction. A null pointer
+// marks a hole, so null can not be stored.
+template <class T>
+class SlotMap
+{
+public:
+    SlotMap() : head(0), count(0) {};
+
+    class const_iterator {
+    public:
+        const_iterator() : p(0), e(0) {};
+        const_iterator(const T *_p, const T *_e) : p(_p), e(_e)
+            { skip(); };
+        const T& operator*() const { return(*p); };
+        const_iterator& operator++() { p++; skip(); return(*this); };
+        const_iterator operator++(int)
+            { const_iterator tmp = *this; ++(*this); return(tmp); };
+        bool operator==(const const_iterator &it) const
+            { return(p == it.p); };
+        bool operator!=(const const_iterator &it) const
+            { return(p != it.p); };
+    private:
+        const T *p;
+        const T *e;
+        void skip() { while (p != e && !(*p)) p++; };
+    };
+
+    const_iterator begin() const
+        { return(const_iterator(data() + head, data() + dense.size())); };
+    const_iterator end() const
+        { return(const_iterator(data() + dense.size(),
+                                data() + dense.size())); };
+
+    unsigned int size() const { return(count); };
+    bool empty() const { return(count == 0); };
+
+    void reserve(unsigned int n)
+        { dense.reserve(n); denseslot.reserve(n); slotindex.reserve(n);
+          slotgen.reserve(n); };
+
+    // Appends x at the back and returns its handle
+    SlotHandle insert(T x) {
+        SlotHandle h;
+        if (freeslots.empty()) {
+            h.slot = slotindex.size();
+            slotindex.push_back(0);
+            slotgen.push_back(0);
+        } else {
+            h.slot = freeslots.back();
+            freeslots.pop_back();
+        }
+        h.gen = slotgen[h.slot];
+        slotindex[h.slot] = dense.size();
+        dense.push_back(x);
+        denseslot.push_back(h.slot);
+        count++;
+        return(h);
+    };
+
+    bool valid(SlotHandle h) const
+        { return(h.slot < slotgen.size() && slotgen[h.slot] == h.gen); };
+
+    T get(SlotHandle h) const
+        { return(valid(h) ? dense[slotindex[h.slot]] : 0); };
+
+    void erase(SlotHandle h) {
+        if (!valid(h)) return;
+        unsigned int i = slotindex[h.slot];
+        dense[i] = 0;
+        release(h.slot);
+        if (i == head) advance();
+        shrink();
+    };
+
+    // The oldest element, ie. the one inserted first
+    T front() const { return(count ? dense[head] : 0); };
+
+    void pop_front() {
+        if (!count) return;
+        dense[head] = 0;
+        release(denseslot[head]);
+        advance();
+        shrink();
+    };
+
+    // Sorts the elements; the handles remain valid
+    template <class Compare>
+    void sort(Compare comp) {
+        compact();
+        std::vector<std::pair<T, unsigned int> > tmp(dense.size());
+        for (unsigned int i = 0; i < dense.size(); i++) {
+            tmp[i] = std::make_pair(dense[i], denseslot[i]);
+        }
+        std::stable_sort(tmp.begin(), tmp.end(), PairCompare<Compare>(comp));
+        for (unsigned int i = 0; i < tmp.size(); i++) {
+            dense[i] = tmp[i].first;
+            denseslot[i] = tmp[i].second;
+            slotindex[denseslot[i]] = i;
+        }
+    };
+
+private:
+    std::vector<T> dense;
+    std::vector<unsigned int> denseslot; // slot of each element in dense
+    std::vector<unsigned int> slotindex; // position in dense of each slot
+    std::vector<unsigned int> slotgen;
+    std::vector<unsigned int> freeslots;
+    unsigned int head; // position of the first element in dense
+    unsigned int count;
+
+    template <class Compare>
+    struct PairCompare {
+        Compare comp;
+        PairCompare(Compare _comp) : comp(_comp) {};
+        bool operator()(const std::pair<T, unsigned int> &a,
+                        const std::pair<T, unsigned int> &b) const
+            { return(comp(a.first, b.first)); };
+    };
+
+    const T *data() const { return(dense.empty() ? 0 : &dense[0]); };
+
+    void release(unsigned int slot) {
+        slotgen[slot]++;
+        freeslots.push_back(slot);
+        count--;
+    };
+
+    void advance() {
+        while (head < dense.size() && !dense[head]) head++;
+        if (head == dense.size()) {
+            dense.clear();
+            denseslot.clear();
+            head = 0;
+        }
+    };
+
+    // Compact once at least half of the vector are holes, which keeps erasing
+    // amortised constant time
+    void shrink() {
+        if (dense.size() > 64 && 2*count < dense.size()) compact();
+    };
+
+    // Removes the holes, keeping the order
+    void compact() {
+        unsigned int j = 0;
+        for (unsigned int i = head; i < dense.size(); i++) {
+            if (dense[i]) {
+                dense[j] = dense[i];
+                denseslot[j] = denseslot[i];
+                slotindex[denseslot[j]] = j;
+                j++;
+            }
+        }
+        dense.resize(j);
+        denseslot.resize(j);
+        head = 0;
+    };
+};
+
+#endif
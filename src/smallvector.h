@@ -0,0 +1,131 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Adrian Roellin   *
+ *   roellin@ispm.unibe.ch   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+
+// A vector that stores up to N elements inside the object itself and only
+// allocates memory if it gets longer; meant for the short lists a Person
+// keeps (eg. the current partnerships). The elements are copied with memcpy,
+// so T must be a plain type (pointers or structs of numbers). The interface
+// follows std::vector, with remove() from std::list.
+template <class T, unsigned int N>
+class SmallVector
+{
+public:
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    SmallVector() : p(buf), n(0), cap(N) {};
+    SmallVector(const SmallVector &v) : p(buf), n(0), cap(N)
+        { reserve(v.n); memcpy(p, v.p, v.n*sizeof(T)); n = v.n; };
+    ~SmallVector() { if (p != buf) delete[] p; };
+    SmallVector &operator=(const SmallVector &v) {
+        if (this != &v) {
+            n = 0;
+            reserve(v.n);
+            memcpy(p, v.p, v.n*sizeof(T));
+            n = v.n;
+        }
+        return(*this);
+    };
+
+    iterator begin() { return(p); };
+    iterator end() { return(p + n); };
+    const_iterator begin() const { return(p); };
+    const_iterator end() const { return(p + n); };
+    reverse_iterator rbegin() { return(reverse_iterator(end())); };
+    reverse_iterator rend() { return(reverse_iterator(begin())); };
+    const_reverse_iterator rbegin() const
+        { return(const_reverse_iterator(end())); };
+    const_reverse_iterator rend() const
+        { return(const_reverse_iterator(begin())); };
+
+    unsigned int size() const { return(n); };
+    bool empty() const { return(n == 0); };
+    // the number of elements that fit without allocating
+    unsigned int capacity() const { return(cap); };
+    // true if the elements are stored outside of the object
+    bool isAllocated() const { return(p != buf); };
+
+    T &operator[](unsigned int i) { return(p[i]); };
+    const T &operator[](unsigned int i) const { return(p[i]); };
+    T &front() { return(p[0]); };
+    const T &front() const { return(p[0]); };
+    T &back() { return(p[n-1]); };
+    const T &back() const { return(p[n-1]); };
+
+    void push_back(const T &x) {
+        if (n == cap) reserve(cap ? 2*cap : 4);
+        p[n++] = x;
+    };
+    void pop_back() { n--; };
+    // inserting at the front moves all elements, so only use it on short
+    // lists
+    void push_front(const T &x) {
+        if (n == cap) reserve(cap ? 2*cap : 4);
+        memmove(p + 1, p, n*sizeof(T));
+        p[0] = x;
+        n++;
+    };
+    void clear() { n = 0; };
+    // inserts x before 'it' and returns an iterator pointing to it
+    iterator insert(iterator it, const T &x) {
+        unsigned int i = it - begin();
+        if (n == cap) reserve(cap ? 2*cap : 4);
+        memmove(p + i + 1, p + i, (n - i)*sizeof(T));
+        p[i] = x;
+        n++;
+        return(p + i);
+    };
+
+    iterator erase(iterator it) {
+        memmove(it, it + 1, (end() - it - 1)*sizeof(T));
+        n--;
+        return(it);
+    };
+    // removes all elements equal to x, keeping the order of the others
+    void remove(const T &x) {
+        iterator last = std::remove(begin(), end(), x);
+        n = last - begin();
+    };
+
+    void reserve(unsigned int size) {
+        if (size <= cap) return;
+        T *q = new T[size];
+        memcpy(q, p, n*sizeof(T));
+        if (p != buf) delete[] p;
+        p = q;
+        cap = size;
+    };
+
+private:
+    T *p;
+    unsigned int n;
+    unsigned int cap;
+    T buf[N];
+};
+
+#endif
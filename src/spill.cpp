@@ -0,0 +1,194 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Adrian Roellin   *
+ *   roellin@ispm.unibe.ch   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "spill.h"
+#include "person.h"
+#include "infection.h"
+#include "partnership.h"
+#include "rif.h"
+
+using namespace std;
+
+PersonRecord makePersonRecord(Person *p)
+{
+    PersonRecord r;
+    r.puid = p->puid;
+    r.type = p->getType();
+    r.bin = p->getBinLinearised();
+    r.timebirth = p->getTimeBirth();
+    r.timedeath = p->getTimeDeath();
+    r.curnumpartners = p->getNumber(NumberOfPartnersCurrent);
+    r.totnumpartners = p->getNumber(NumberOfPartnersTotal);
+    r.oneypartners = p->getNumber(NumberOfPartnersWithin);
+    r.contacts = p->getNumber(NumberOfContacts);
+    r.contactsunprot = p->getNumber(NumberOfContactsUnprotected);
+    r.infectionscur = p->getNumber(NumberOfInfectionsCurrent);
+    r.infectionstot = p->getNumber(NumberOfInfectionsTotal);
+    r.infectionswithin = p->getNumber(NumberOfInfectionsWithin);
+    if (p->idsubclass == CLASSPERSONFEMALE) {
+        r.pregnant = ((PersonFemale*)p)->isPregnant();
+        r.children = ((PersonFemale*)p)->getNumber(NumberOfChildren);
+        r.abortions = ((PersonFemale*)p)->getNumber(NumberOfAbortions);
+        r.pregnancies = ((PersonFemale*)p)->getNumber(NumberOfPregnancies);
+    } else if (p->idsubclass == CLASSPERSONMALE) {
+        r.pregnant = INTNA;
+        r.children = ((PersonMale*)p)->getNumber(NumberOfChildren);
+        r.abortions = INTNA;
+        r.pregnancies = INTNA;
+    } else {
+        r.pregnant = INTNA;
+        r.children = INTNA;
+        r.abortions = INTNA;
+        r.pregnancies = INTNA;
+    }
+    r.treatments = p->getNumber(NumberOfTreatments);
+    r.gpvisits = p->getNumber(NumberOfGPVisits);
+    r.notifications = p->getNumber(NumberOfNotifications);
+    return(r);
+}
+
+InfectionRecord makeInfectionRecord(Infection *infection, const Person *host)
+{
+    InfectionRecord r;
+    r.infuid = infection->infuid;
+    r.strainid = infection->getStrainID();
+    r.parentinfuid = infection->getParentInfuid();
+    r.hostpuid = host->puid;
+    r.type = infection->getType();
+    r.bin = infection->getBinLinearised();
+    r.birth = infection->getTimeBirth();
+    r.endinfection = infection->getTimeOfImmunity() < host->getTimeDeath() ?
+        infection->getTimeOfImmunity() : NA_REAL;
+    r.death = infection->getTimeDeath() < host->getTimeDeath() ?
+        infection->getTimeDeath() : NA_REAL;
+    r.psuid = infection->getPartnership() ? 
+        infection->getPartnership()->psuid : 0;
+    return(r);
+}
+
+SpillFile::SpillFile(string filename)
+{
+    if (filename == "") {
+        file = tmpfile();
+    } else {
+        file = fopen(filename.c_str(), "w+b");
+    }
+    if (!file) {
+        error("cannot open spill file '%s'", filename.c_str());
+    }
+    people = 0;
+    bytes = 0;
+}
+
+SpillFile::~SpillFile()
+{
+    if (file) fclose(file);
+}
+
+void SpillFile::writeBytes(const void *p, size_t size)
+{
+    if (fwrite(p, size, 1, file) != 1) {
+        error("cannot write to spill file");
+    }
+    bytes += size;
+}
+
+void SpillFile::readBytes(void *p, size_t size) const
+{
+    if (fread(p, size, 1, file) != 1) {
+        error("cannot read from spill file");
+    }
+}
+
+void SpillFile::skipBytes(long size) const
+{
+    if (size > 0 && fseek(file, size, SEEK_CUR) != 0) {
+        error("cannot read from spill file");
+    }
+}
+
+void SpillFile::write(Person *p, bool gone)
+{
+    const InfectionList *infs = p->getInfections();
+    const InfectionList *infsold = p->getInfectionsOld();
+    
+    Block block;
+    block.person = makePersonRecord(p);
+    block.gone = gone;
+    block.infections = infs->size();
+    block.infectionsold = infsold->size();
+    
+    // reading may have moved the position
+    fseek(file, 0, SEEK_END);
+    writeBytes(&block, sizeof(Block));
+    for (InfectionList::const_iterator it = infs->begin(); 
+        it != infs->end(); it++) {
+        InfectionRecord r = makeInfectionRecord(*it, p);
+        writeBytes(&r, sizeof(InfectionRecord));
+    }
+    for (InfectionList::const_iterator it = infsold->begin(); 
+        it != infsold->end(); it++) {
+        InfectionRecord r = makeInfectionRecord(*it, p);
+        writeBytes(&r, sizeof(InfectionRecord));
+    }
+    people++;
+}
+
+bool SpillFile::nextBlock(Block &block) const
+{
+    return(fread(&block, sizeof(Block), 1, file) == 1);
+}
+
+template <class T>
+void SpillFile::readRecords(vector<T> &rows, unsigned int n) const
+{
+    if (n == 0) return;
+    size_t size = rows.size();
+    rows.resize(size + n);
+    readBytes(&rows[size], n*sizeof(T));
+}
+
+void SpillFile::readPeople(vector<PersonRecord> &rows) const
+{
+    rewind(file);
+    Block block;
+    while (nextBlock(block)) {
+        if (!block.gone) rows.push_back(block.person);
+        skipBytes((block.infections + block.infectionsold)*
+            sizeof(InfectionRecord));
+    }
+}
+
+void SpillFile::readInfections(vector<InfectionRecord> &rows, bool old) const
+{
+    rewind(file);
+    Block block;
+    while (nextBlock(block)) {
+        if (block.gone) {
+            skipBytes((block.infections + block.infectionsold)*
+                sizeof(InfectionRecord));
+        } else if (old) {
+            skipBytes(block.infections*sizeof(InfectionRecord));
+            readRecords(rows, block.infectionsold);
+        } else {
+            readRecords(rows, block.infections);
+            skipBytes(block.infectionsold*sizeof(InfectionRecord));
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Adrian Roellin   *
+ *   roellin@ispm.unibe.ch   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef SPILL_H
+#define SPILL_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "typedefs.h"
+
+/**
+ * Returns the exported information about a Person
+ * @param p the Person
+ * @return a PersonRecord
+ */
+PersonRecord makePersonRecord(Person *p);
+/**
+ * Returns the exported information about an Infection
+ * @param infection the Infection
+ * @param host the host of the Infection
+ * @return an InfectionRecord
+ */
+InfectionRecord makeInfectionRecord(Infection *infection, const Person *host);
+
+/**
+ * An append-only file to which dead people are moved after some time (see
+ * 'simulation.remove.peopleolderthan' in the configuration file), so that
+ * they no longer use memory. For each Person a block is written with the
+ * PersonRecord, followed by the records of its infections (the notifications
+ * and GP visits are kept in the logs of the Population). The records are
+ * written in the binary format of the machine and are only meant to be read
+ * again by the same simulation.
+ */
+class SpillFile
+{
+public:
+    /**
+     * Constructor
+     * @param filename the name of the file; if empty, an anonymous temporary
+     * file is used, which is deleted when the model is removed
+     */
+    SpillFile(std::string filename);
+    /**
+     * Destructor; closes the file
+     */
+    ~SpillFile();
+    /**
+     * Writes a Person with its infections and records to the end of the file;
+     * the Person itself is not changed
+     * @param p the Person
+     * @param gone true if the Person emigrated, false if it died
+     */
+    void write(Person *p, bool gone);
+    /**
+     * Appends the records of the dead people in the file
+     * @param rows the vector to append to
+     */
+    void readPeople(std::vector<PersonRecord> &rows) const;
+    /**
+     * Appends the records of the infections of the dead people in the file
+     * @param rows the vector to append to
+     * @param old if true, the old infections of the people, otherwise the
+     * current ones
+     */
+    void readInfections(std::vector<InfectionRecord> &rows, bool old) const;
+    /** @return the number of people in the file */
+    Counter getNumberOfPeople() const { return(people); };
+    /** @return the size of the file in bytes */
+    Counter getBytes() const { return(bytes); };
+
+private:
+    /** The header of the block of each Person */
+    typedef struct {
+        PersonRecord person;
+        int gone;
+        unsigned int infections;
+        unsigned int infectionsold;
+    } Block;
+    
+    FILE *file;
+    Counter people;
+    Counter bytes;
+    
+    void writeBytes(const void *p, std::size_t size);
+    void readBytes(void *p, std::size_t size) const;
+    void skipBytes(long size) const;
+    bool nextBlock(Block &block) const;
+    template <class T>
+    void readRecords(std::vector<T> &rows, unsigned int n) const;
+};
+
+#endif
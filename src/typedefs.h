@@ -24,6 +24,9 @@
 #include <list>
 #include <vector>
 
+#include "slotmap.h"
+#include "smallvector.h"
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -55,6 +58,7 @@ class EventImmigration;
 class EventBinChange;
 class EventPSInitiate;
 class EventHaveSex;
+class EventTransmission;
 class EventRemoveOld;
 class EventVisitGP;
 class EventProvokeGPVisit;
@@ -71,6 +75,7 @@ class PersonCreatorFemale;
 class PersonCreatorMale;
 
 class Partnership;
+class SpillFile;
 class PSCreator;
 class PSFormer;
 class PSFormerIndivSearch;
@@ -90,6 +95,18 @@ enum ConditioningType {
     OnTime
 };
 
+/** Classification of a Distribution (and hence of an Attribute) by what its
+samples depend on; the order matters: a Distribution built from others is at
+least as impure as the most impure of them */
+enum Purity {
+    PurityConstant = 0,  // always the same value
+    PurityTypeBin,       // a function of the type and the bin only
+    PurityAge,           // deterministic, but changes with age or time
+    PurityState,         // deterministic, but depends on the history of the
+                         // object (number of partners, pregnancy, host, ...)
+    PurityStochastic     // random
+};
+
 enum TypeOfTreatment {
     TreatmentGeneral = 0,
     TreatmentSpecific    
@@ -98,7 +115,8 @@ enum TypeOfTreatment {
 enum CauseVisitGP {
     CauseSymptomsGeneral = 0,
     CauseSymptomsSpecific,
-    CauseNotified
+    CauseNotified,
+    CauseScreening
 };
 
 enum NumberOf {
@@ -153,7 +171,8 @@ enum CauseAbortion {
 
 enum EnumRemove{
     RemovePartnerships = 0,
-    RemoveInfections
+    RemoveInfections,
+    RemovePeople
 };
 
 /** The type to move events around. At the moment just a pointer to the class
@@ -244,6 +263,61 @@ typedef struct {
     Bin  pbin;  //at the time of visit
 } SingleGPVisit;
 
+// The exported information about a Person, used for people that were moved
+// from the memory to the spill file (see SpillFile); counts that do not apply
+// are NA
+typedef struct {
+    Counter puid;
+    Type type;
+    Bin bin; // linearised
+    Time timebirth;
+    Time timedeath;
+    Number curnumpartners;
+    Number totnumpartners;
+    Number oneypartners;
+    Number contacts;
+    Number contactsunprot;
+    Number pregnant;
+    Number children;
+    Number abortions;
+    Number pregnancies;
+    Number infectionscur;
+    Number infectionstot;
+    Number infectionswithin;
+    Number treatments;
+    Number gpvisits;
+    Number notifications;
+} PersonRecord;
+
+// The exported information about an Infection (see PersonRecord); the ids
+// are 0 if there is no parent or partnership, times that did not happen
+// before the death of the host are NA
+typedef struct {
+    Counter infuid;
+    Counter strainid;
+    Counter parentinfuid;
+    Counter hostpuid;
+    Type type;
+    Bin bin; // linearised
+    Time birth;
+    Time endinfection;
+    Time death;
+    Counter psuid;
+} InfectionRecord;
+
+// An entry in the log of transmissions kept by the Population; there is one
+// entry for each infection, also for those without parent, in which case the
+// parent and partnership ids are 0
+typedef struct {
+    Time time;
+    Counter infuid;
+    Counter parentinfuid;
+    Counter strainid;
+    Counter hostpuid;
+    Counter psuid;
+    Type type;
+} TransmissionRecord;
+
 typedef struct {
     unsigned int n;      //length
     int *ix;    //integer version of x-values
@@ -256,21 +330,23 @@ typedef struct {
 
 typedef struct {
     int pos_v;
-    std::list<Person*>::iterator pos_l;
+    SlotHandle pos_h; // handle in the list of active, dead or gone people
     int adhoc; // this is used to number the population from 1 to size and is
              //needed to produce R network objects
 } PopID;
 
 typedef struct {
-    std::list<Partnership*>::iterator pos_l;
+    SlotHandle pos_h; // handle in the list of active or ended partnerships
 } PartnershipID;
 
-typedef std::list<Person*> PeopleList;
+typedef SlotMap<Person*> PeopleStore;
 typedef std::vector<Person*> PeopleVector;
-typedef std::list<Partnership*> PartnershipList;
-typedef std::list<Infection*> InfectionList;
-typedef std::list<Notification> NotificationList;
-typedef std::list<SingleNotification> SingleNotificationList;
-typedef std::list<SingleGPVisit> SingleGPVisitList;
+typedef SlotMap<Partnership*> PartnershipStore;
+// The lists kept by each Person; most people have only a few partnerships and
+// infections, so these are stored inside the Person object; the records of
+// the notifications and GP visits are kept in the logs of the Population
+typedef SmallVector<Partnership*, 2> PartnershipList;
+typedef SmallVector<Infection*, 2> InfectionList;
+typedef SmallVector<Notification, 1> NotificationList;
 
 #endif